@@ -0,0 +1,267 @@
+//	Anti-aliased Euclidean distance transform (after Stefan Gustavson's
+//	edtaa3).  Instead of a binary bitmap, it reads coverage values (0 is
+//	outside, 255 inside), and uses the local gradient plus the coverage
+//	of the nearest edge pixel to place the edge inside that pixel.  This
+//	gives sub-pixel distances from a grayscale raster, so the glyphs can
+//	be rendered at a small fraction of the mono oversampling.  Distances
+//	are propagated 8SSEDT style (offsets to the nearest edge pixel), and
+//	the sweeps repeat until nothing changes.
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "DistanceField.hpp"
+
+//	'not set yet'
+static const double aa_far = 1e6;
+
+//	normalized Sobel-like gradient, only at edge (partly covered) pixels
+static void compute_gradient(
+		const std::vector< double > &img,
+		int w, int h,
+		std::vector< double > &gx,
+		std::vector< double > &gy )
+{
+	const double sqrt2 = 1.4142136;
+	gx.assign( w * h, 0.0 );
+	gy.assign( w * h, 0.0 );
+	for( int y = 1; y < h - 1; ++y )
+	{
+		for( int x = 1; x < w - 1; ++x )
+		{
+			int k = y * w + x;
+			if( (img[k] > 0.0) && (img[k] < 1.0) )
+			{
+				double dx = -img[k-w-1] - sqrt2*img[k-1] - img[k+w-1]
+						+ img[k-w+1] + sqrt2*img[k+1] + img[k+w+1];
+				double dy = -img[k-w-1] - sqrt2*img[k-w] - img[k-w+1]
+						+ img[k+w-1] + sqrt2*img[k+w] + img[k+w+1];
+				double len = sqrt( dx*dx + dy*dy );
+				if( len > 0.0 )
+				{
+					dx /= len;
+					dy /= len;
+				}
+				gx[k] = dx;
+				gy[k] = dy;
+			}
+		}
+	}
+}
+
+//	distance from a pixel's centre to the edge through it, given the
+//	edge direction (gx,gy) and the pixel's coverage a
+static double edge_distance( double gx, double gy, double a )
+{
+	if( (gx == 0.0) || (gy == 0.0) )
+	{
+		//	exact for axis aligned edges, a fair guess otherwise
+		return 0.5 - a;
+	}
+	double len = sqrt( gx*gx + gy*gy );
+	gx = fabs( gx / len );
+	gy = fabs( gy / len );
+	//	everything is symmetric, so work in the first octant
+	if( gx < gy )
+	{
+		std::swap( gx, gy );
+	}
+	double a1 = 0.5 * gy / gx;
+	if( a < a1 )
+	{
+		return 0.5 * (gx + gy) - sqrt( 2.0 * gx * gy * a );
+	}
+	if( a < 1.0 - a1 )
+	{
+		return (0.5 - a) * gx;
+	}
+	return -0.5 * (gx + gy) + sqrt( 2.0 * gx * gy * (1.0 - a) );
+}
+
+//	distance to the edge in pixel e, seen from offset (dx,dy) away
+static double distance_aa(
+		const std::vector< double > &img,
+		const std::vector< double > &gx,
+		const std::vector< double > &gy,
+		int e, int dx, int dy )
+{
+	double a = std::min( 1.0, std::max( 0.0, img[e] ) );
+	if( a == 0.0 )
+	{
+		return aa_far;
+	}
+	double di = sqrt( (double)(dx*dx + dy*dy) );
+	if( di == 0.0 )
+	{
+		return edge_distance( gx[e], gy[e], a );
+	}
+	//	far away, the direction to the edge is a better gradient
+	return di + edge_distance( dx, dy, a );
+}
+
+//	distance from every pixel to the covered area of img, nothing is
+//	propagated further than 'limit' (those pixels may stay at aa_far)
+static void edtaa(
+		const std::vector< double > &img,
+		int w, int h,
+		double limit,
+		std::vector< double > &dist )
+{
+	std::vector< double > gx, gy;
+	compute_gradient( img, w, h, gx, gy );
+	//	offset from each pixel to its nearest edge pixel
+	std::vector< short > ox( w * h, 0 ), oy( w * h, 0 );
+	dist.resize( w * h );
+	for( int i = 0; i < w * h; ++i )
+	{
+		if( img[i] <= 0.0 )
+		{
+			dist[i] = aa_far;
+		} else if( img[i] < 1.0 )
+		{
+			dist[i] = edge_distance( gx[i], gy[i], img[i] );
+		} else
+		{
+			dist[i] = 0.0;
+		}
+	}
+	const double epsilon = 1e-3;
+	//	try the neighbour at (nx,ny) relative to pixel i
+	auto test = [&]( int i, int nx, int ny, bool &changed )
+	{
+		int c = i + nx + ny * w;
+		if( dist[c] >= limit )
+		{
+			//	nothing known there yet, or too far to matter
+			return;
+		}
+		int dx = ox[c] - nx;
+		int dy = oy[c] - ny;
+		//	the edge pixel c points at
+		int e = c - ox[c] - oy[c] * w;
+		double d = distance_aa( img, gx, gy, e, dx, dy );
+		if( d < dist[i] - epsilon )
+		{
+			ox[i] = dx;
+			oy[i] = dy;
+			dist[i] = d;
+			changed = true;
+		}
+	};
+	bool changed = true;
+	while( changed )
+	{
+		changed = false;
+		//	down the image: from above and the left, then from the right
+		for( int y = 1; y < h; ++y )
+		{
+			for( int x = 0; x < w; ++x )
+			{
+				int i = y * w + x;
+				if( dist[i] <= 0.0 ) continue;
+				if( x > 0 ) test( i, -1, 0, changed );
+				if( x > 0 ) test( i, -1, -1, changed );
+				test( i, 0, -1, changed );
+				if( x < w - 1 ) test( i, 1, -1, changed );
+			}
+			for( int x = w - 2; x >= 0; --x )
+			{
+				int i = y * w + x;
+				if( dist[i] <= 0.0 ) continue;
+				test( i, 1, 0, changed );
+			}
+		}
+		//	back up: from below and the right, then from the left
+		for( int y = h - 2; y >= 0; --y )
+		{
+			for( int x = w - 1; x >= 0; --x )
+			{
+				int i = y * w + x;
+				if( dist[i] <= 0.0 ) continue;
+				if( x < w - 1 ) test( i, 1, 0, changed );
+				if( x < w - 1 ) test( i, 1, 1, changed );
+				test( i, 0, 1, changed );
+				if( x > 0 ) test( i, -1, 1, changed );
+			}
+			for( int x = 1; x < w; ++x )
+			{
+				int i = y * w + x;
+				if( dist[i] <= 0.0 ) continue;
+				test( i, -1, 0, changed );
+			}
+		}
+	}
+}
+
+void AA_distance_field(
+		const unsigned char *img,
+		int w, int h,
+		int max_radius,
+		std::vector< float > &field )
+{
+	//	one pixel of slack, so the clamped samples still interpolate
+	double limit = max_radius + 1.5;
+	std::vector< double > cover( w * h );
+	for( int i = 0; i < w * h; ++i )
+	{
+		cover[i] = img[i] / 255.0;
+	}
+	std::vector< double > outside, inside;
+	edtaa( cover, w, h, limit, outside );
+	for( int i = 0; i < w * h; ++i )
+	{
+		cover[i] = 1.0 - cover[i];
+	}
+	edtaa( cover, w, h, limit, inside );
+	field.resize( w * h );
+	for( int i = 0; i < w * h; ++i )
+	{
+		//	positive inside, like the rest of the encoding
+		field[i] = std::min( std::max( inside[i], 0.0 ), limit ) -
+				std::min( std::max( outside[i], 0.0 ), limit );
+	}
+}
+
+float sample_distance_field(
+		const std::vector< float > &field,
+		int w, int h,
+		float x, float y )
+{
+	x = std::min( std::max( x, 0.0f ), w - 1.0f );
+	y = std::min( std::max( y, 0.0f ), h - 1.0f );
+	int x0 = std::min( (int)x, w - 2 < 0 ? 0 : w - 2 );
+	int y0 = std::min( (int)y, h - 2 < 0 ? 0 : h - 2 );
+	int x1 = std::min( x0 + 1, w - 1 );
+	int y1 = std::min( y0 + 1, h - 1 );
+	float fx = x - x0;
+	float fy = y - y0;
+	float top = field[y0 * w + x0] * (1.0f - fx) + field[y0 * w + x1] * fx;
+	float bottom = field[y1 * w + x0] * (1.0f - fx) + field[y1 * w + x1] * fx;
+	return top * (1.0f - fy) + bottom * fy;
+}
+
+unsigned char encode_SDF_signed( float d, int max_radius )
+{
+	return encode_SDF_distance( d * d, d > 0.0f, max_radius );
+}
+
+void render_SDF_grid_AA(
+		const unsigned char *img,
+		int w, int h,
+		const std::vector< int > &xs,
+		const std::vector< int > &ys,
+		int max_radius,
+		unsigned char *sdf )
+{
+	std::vector< float > field;
+	AA_distance_field( img, w, h, max_radius, field );
+	int nx = xs.size();
+	for( unsigned int j = 0; j < ys.size(); ++j )
+	{
+		for( int i = 0; i < nx; ++i )
+		{
+			sdf[i + j * nx] = encode_SDF_signed( field[ys[j] * w + xs[i]], max_radius );
+		}
+	}
+}
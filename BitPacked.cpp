@@ -0,0 +1,227 @@
+//	Distance search on 1 bit per pixel rows (MSB first, the FreeType
+//	FT_PIXEL_MODE_MONO layout), without ever expanding them to bytes.
+//	Each row of the search window is XORed against the sample's value,
+//	and count-leading/trailing-zeros find the nearest differing pixel on
+//	either side of the sample in one step per 64 pixels.  Rows are
+//	visited outwards from the sample and the search stops once the row
+//	distance alone can't beat the best hit.  The result is exact.
+
+#include <cstring>
+#include <vector>
+
+#include "DistanceField.hpp"
+
+typedef unsigned long long bits64;
+
+//	64 bits of a row starting at bit 64*k, zero past the end of the row
+static inline bits64 load_be64( const unsigned char *row, int nbytes, int k )
+{
+	int at = k * 8;
+	bits64 word = 0;
+	if( at + 8 <= nbytes )
+	{
+		unsigned char b[8];
+		memcpy( b, row + at, 8 );
+		for( int i = 0; i < 8; ++i )
+		{
+			word = (word << 8) | b[i];
+		}
+	} else
+	{
+		for( int i = 0; i < 8; ++i )
+		{
+			word <<= 8;
+			if( at + i < nbytes )
+			{
+				word |= row[at + i];
+			}
+		}
+	}
+	return word;
+}
+
+//	first bit position in [from,to] that differs from v, or -1
+static int find_right(
+		const unsigned char *row, int nbytes,
+		int from, int to,
+		int v )
+{
+	const bits64 flip = v ? ~0ull : 0ull;
+	for( int k = from >> 6; (k << 6) <= to; ++k )
+	{
+		int base = k << 6;
+		bits64 word = load_be64( row, nbytes, k ) ^ flip;
+		if( from > base ) { word &= ~0ull >> (from - base); }
+		if( to < base + 63 ) { word &= ~(~0ull >> (to - base + 1)); }
+		if( word )
+		{
+			return base + __builtin_clzll( word );
+		}
+	}
+	return -1;
+}
+
+//	last bit position in [from,to] that differs from v, or -1
+static int find_left(
+		const unsigned char *row, int nbytes,
+		int from, int to,
+		int v )
+{
+	const bits64 flip = v ? ~0ull : 0ull;
+	for( int k = to >> 6; k >= (from >> 6); --k )
+	{
+		int base = k * 64;
+		bits64 word = load_be64( row, nbytes, k ) ^ flip;
+		if( from > base ) { word &= ~0ull >> (from - base); }
+		if( to < base + 63 ) { word &= ~(~0ull >> (to - base + 1)); }
+		if( word )
+		{
+			return base + 63 - __builtin_ctzll( word );
+		}
+	}
+	return -1;
+}
+
+static inline int packed_pixel( const packed_bitmap &pb, int x, int y )
+{
+	x -= pb.ox;
+	y -= pb.oy;
+	if( (x < 0) || (x >= pb.bw) || (y < 0) || (y >= pb.bh) )
+	{
+		return 0;
+	}
+	const unsigned char *row = pb.bits + y * pb.pitch;
+	return (row[x >> 3] >> (7 - (x & 7))) & 1;
+}
+
+//	horizontal distance from x to the nearest pixel != v in row yy,
+//	within [lo,hi], or -1 if there is none
+static int nearest_in_packed_row(
+		const packed_bitmap &pb,
+		int yy, int x,
+		int lo, int hi,
+		int v )
+{
+	int ry = yy - pb.oy;
+	if( (ry < 0) || (ry >= pb.bh) )
+	{
+		//	the whole row is off
+		return v ? 0 : -1;
+	}
+	int best = -1;
+	if( v )
+	{
+		//	everything left and right of the bits is off
+		int left_end = pb.ox - 1;
+		int right_start = pb.ox + pb.bw;
+		if( x <= left_end || x >= right_start )
+		{
+			return 0;
+		}
+		if( left_end >= lo ) { best = x - left_end; }
+		if( (right_start <= hi) && ((best < 0) || (right_start - x < best)) )
+		{
+			best = right_start - x;
+		}
+	}
+	int a_lo = (lo > pb.ox) ? lo : pb.ox;
+	int a_hi = (hi < pb.ox + pb.bw - 1) ? hi : pb.ox + pb.bw - 1;
+	if( a_lo > a_hi )
+	{
+		return best;
+	}
+	const unsigned char *row = pb.bits + ry * pb.pitch;
+	int nbytes = (pb.bw + 7) >> 3;
+	if( x <= a_hi )
+	{
+		int from = (x > a_lo) ? x : a_lo;
+		int p = find_right( row, nbytes, from - pb.ox, a_hi - pb.ox, v );
+		if( p >= 0 )
+		{
+			int d = p + pb.ox - x;
+			if( (best < 0) || (d < best) ) { best = d; }
+		}
+	}
+	if( x >= a_lo )
+	{
+		int to = (x < a_hi) ? x : a_hi;
+		int p = find_left( row, nbytes, a_lo - pb.ox, to - pb.ox, v );
+		if( p >= 0 )
+		{
+			int d = x - (p + pb.ox);
+			if( (best < 0) || (d < best) ) { best = d; }
+		}
+	}
+	return best;
+}
+
+unsigned char get_SDF_packed(
+		const packed_bitmap &pb,
+		int x, int y,
+		int max_radius )
+{
+	int v = packed_pixel( pb, x, y );
+	int best = max_radius * max_radius + 1;
+	int lo = (x - max_radius < 0) ? 0 : x - max_radius;
+	int hi = (x + max_radius >= pb.w) ? pb.w - 1 : x + max_radius;
+	for( int dy = 0; (dy <= max_radius) && (dy * dy < best); ++dy )
+	{
+		for( int yy = y - dy; yy <= y + dy; yy += (dy > 0) ? 2 * dy : 1 )
+		{
+			if( (yy < 0) || (yy >= pb.h) )
+			{
+				continue;
+			}
+			int d = nearest_in_packed_row( pb, yy, x, lo, hi, v );
+			if( (d >= 0) && (d * d + dy * dy < best) )
+			{
+				best = d * d + dy * dy;
+			}
+		}
+	}
+	return encode_SDF_distance( best, v != 0, max_radius );
+}
+
+void pack_bitmap(
+		const unsigned char *img,
+		int w, int h,
+		std::vector< unsigned char > &bits,
+		packed_bitmap &pb )
+{
+	int pitch = (w + 7) >> 3;
+	bits.assign( pitch * h, 0 );
+	for( int y = 0; y < h; ++y )
+	{
+		const unsigned char *row = img + y * w;
+		unsigned char *b = &bits[y * pitch];
+		for( int x = 0; x < w; ++x )
+		{
+			if( row[x] )
+			{
+				b[x >> 3] |= 0x80 >> (x & 7);
+			}
+		}
+	}
+	pb.w = pb.bw = w;
+	pb.h = pb.bh = h;
+	pb.ox = pb.oy = 0;
+	pb.pitch = pitch;
+	pb.bits = bits.empty() ? NULL : &bits[0];
+}
+
+void render_SDF_grid_packed(
+		const packed_bitmap &pb,
+		const std::vector< int > &xs,
+		const std::vector< int > &ys,
+		int max_radius,
+		unsigned char *sdf )
+{
+	int nx = xs.size();
+	for( unsigned int j = 0; j < ys.size(); ++j )
+	{
+		for( int i = 0; i < nx; ++i )
+		{
+			sdf[i + j * nx] = get_SDF_packed( pb, xs[i], ys[j], max_radius );
+		}
+	}
+}
@@ -0,0 +1,182 @@
+//	Nearest-edge queries against the boundary pixels only.  The nearest
+//	opposite pixel to any sample always has a 4-neighbour with the
+//	sample's value (the neighbour one step back towards the sample), so
+//	only those boundary pixels can ever be the answer.  They are
+//	extracted once per bitmap and bucketed into a uniform grid, and each
+//	sample visits the grid cells ring by ring, stopping once a ring is
+//	further away than the best pixel found.  The result is exact.
+
+#include <algorithm>
+#include <vector>
+
+#include "DistanceField.hpp"
+
+//	the boundary pixels of one value, bucketed by cell (CSR layout)
+struct boundary_grid
+{
+	int cell;
+	int cw, ch;
+	std::vector< int > start;	//	cw * ch + 1 entries
+	std::vector< int > px, py;
+};
+
+static void build_boundary_grids(
+		const unsigned char *img,
+		int w, int h,
+		int cell,
+		boundary_grid grids[2] )
+{
+	//	grids[1] holds "on" pixels next to an "off" one, grids[0] the reverse
+	std::vector< unsigned char > edge( w * h, 0 );
+	for( int y = 0; y < h; ++y )
+	{
+		const unsigned char *row = img + y * w;
+		unsigned char *e = &edge[y * w];
+		for( int x = 0; x + 1 < w; ++x )
+		{
+			if( row[x] != row[x+1] )
+			{
+				e[x] = 1;
+				e[x+1] = 1;
+			}
+		}
+		if( y + 1 < h )
+		{
+			for( int x = 0; x < w; ++x )
+			{
+				if( row[x] != row[x+w] )
+				{
+					e[x] = 1;
+					e[x+w] = 1;
+				}
+			}
+		}
+	}
+	for( int g = 0; g < 2; ++g )
+	{
+		grids[g].cell = cell;
+		grids[g].cw = (w + cell - 1) / cell;
+		grids[g].ch = (h + cell - 1) / cell;
+		grids[g].start.assign( grids[g].cw * grids[g].ch + 1, 0 );
+	}
+	//	count, then fill
+	for( int y = 0; y < h; ++y )
+	{
+		for( int x = 0; x < w; ++x )
+		{
+			if( edge[y * w + x] )
+			{
+				boundary_grid &g = grids[img[y * w + x] != 0];
+				++g.start[(y / cell) * g.cw + x / cell + 1];
+			}
+		}
+	}
+	std::vector< int > fill[2];
+	for( int k = 0; k < 2; ++k )
+	{
+		boundary_grid &g = grids[k];
+		for( unsigned int c = 1; c < g.start.size(); ++c )
+		{
+			g.start[c] += g.start[c-1];
+		}
+		g.px.resize( g.start.back() );
+		g.py.resize( g.start.back() );
+		fill[k].assign( g.start.begin(), g.start.end() - 1 );
+	}
+	for( int y = 0; y < h; ++y )
+	{
+		for( int x = 0; x < w; ++x )
+		{
+			if( edge[y * w + x] )
+			{
+				int k = (img[y * w + x] != 0);
+				boundary_grid &g = grids[k];
+				int at = fill[k][(y / cell) * g.cw + x / cell]++;
+				g.px[at] = x;
+				g.py[at] = y;
+			}
+		}
+	}
+}
+
+//	squared distance to the nearest pixel of the grid within max_radius,
+//	or max_radius^2+1 if there is none
+static int nearest_boundary(
+		const boundary_grid &g,
+		int x, int y,
+		int max_radius )
+{
+	int best = max_radius * max_radius + 1;
+	int cx = x / g.cell;
+	int cy = y / g.cell;
+	int max_ring = max_radius / g.cell + 1;
+	for( int ring = 0; ring <= max_ring; ++ring )
+	{
+		//	every cell in this ring is at least this far away (in x or y)
+		if( ring > 0 )
+		{
+			int lx = std::min( x - (cx - ring + 1) * g.cell + 1, (cx + ring) * g.cell - x );
+			int ly = std::min( y - (cy - ring + 1) * g.cell + 1, (cy + ring) * g.cell - y );
+			int lb = std::min( lx, ly );
+			if( lb * lb >= best )
+			{
+				break;
+			}
+		}
+		for( int j = cy - ring; j <= cy + ring; ++j )
+		{
+			if( (j < 0) || (j >= g.ch) )
+			{
+				continue;
+			}
+			bool edge_row = (j == cy - ring) || (j == cy + ring);
+			int step = edge_row ? 1 : 2 * ring;
+			for( int i = cx - ring; i <= cx + ring; i += (step > 0 ? step : 1) )
+			{
+				if( (i < 0) || (i >= g.cw) )
+				{
+					continue;
+				}
+				int c = j * g.cw + i;
+				for( int k = g.start[c]; k < g.start[c+1]; ++k )
+				{
+					int dx = g.px[k] - x;
+					int dy = g.py[k] - y;
+					int d2 = dx*dx + dy*dy;
+					if( d2 < best )
+					{
+						best = d2;
+					}
+				}
+			}
+		}
+	}
+	return best;
+}
+
+void render_SDF_grid_boundary(
+		const unsigned char *img,
+		int w, int h,
+		const std::vector< int > &xs,
+		const std::vector< int > &ys,
+		int max_radius,
+		unsigned char *sdf )
+{
+	//	a few cells per search radius
+	int cell = std::max( 4, max_radius / 2 );
+	boundary_grid grids[2];
+	build_boundary_grids( img, w, h, cell, grids );
+	int nx = xs.size();
+	for( unsigned int j = 0; j < ys.size(); ++j )
+	{
+		for( int i = 0; i < nx; ++i )
+		{
+			int x = xs[i];
+			int y = ys[j];
+			bool inside = (img[x + y * w] != 0);
+			//	inside samples look for "off" boundary pixels, and vice versa
+			int d2 = nearest_boundary( grids[inside ? 0 : 1], x, y, max_radius );
+			sdf[i + j * nx] = encode_SDF_distance( d2, inside, max_radius );
+		}
+	}
+}
@@ -0,0 +1,201 @@
+#ifndef BOUNDEDQUEUE_H
+#define BOUNDEDQUEUE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+//	A fixed capacity multi-producer / multi-consumer queue without locks
+//	(Dmitry Vyukov's bounded queue).  Every cell carries a sequence number
+//	which tells producers and consumers whose turn it is, so a push or a
+//	pop is one compare-and-swap on the shared position plus a store to
+//	the cell.  try_push / try_pop never block, they fail when the queue
+//	is full / empty.  push / pop sleep instead, on a condition variable
+//	that is only touched when somebody is actually waiting, and close()
+//	tells the consumers that nothing more is coming.
+template< typename T >
+class bounded_queue
+{
+public:
+	//	the capacity is rounded up to a power of 2
+	explicit bounded_queue( size_t capacity )
+	{
+		size_t n = 2;
+		while( n < capacity )
+		{
+			n <<= 1;
+		}
+		cells = std::vector< cell >( n );
+		mask = n - 1;
+		for( size_t i = 0; i < n; ++i )
+		{
+			cells[i].seq.store( i, std::memory_order_relaxed );
+		}
+		enqueue_pos.store( 0, std::memory_order_relaxed );
+		dequeue_pos.store( 0, std::memory_order_relaxed );
+		push_waiters.store( 0, std::memory_order_relaxed );
+		pop_waiters.store( 0, std::memory_order_relaxed );
+		closed.store( false, std::memory_order_relaxed );
+	}
+
+	//	waits while the queue is full
+	void push( const T &value )
+	{
+		if( !try_push( value ) )
+		{
+			std::unique_lock< std::mutex > lock( wait_mutex );
+			start_waiting( push_waiters );
+			while( !try_push( value ) )
+			{
+				not_full.wait( lock );
+			}
+			--push_waiters;
+		}
+		wake( pop_waiters, not_empty );
+	}
+
+	//	waits while the queue is empty, false once it is closed and empty
+	bool pop( T &value )
+	{
+		if( !try_pop( value ) )
+		{
+			std::unique_lock< std::mutex > lock( wait_mutex );
+			start_waiting( pop_waiters );
+			for( ;; )
+			{
+				//	read before the pop: once closed, every push is visible
+				bool was_closed = closed.load( std::memory_order_acquire );
+				if( try_pop( value ) )
+				{
+					break;
+				}
+				if( was_closed )
+				{
+					--pop_waiters;
+					return false;
+				}
+				not_empty.wait( lock );
+			}
+			--pop_waiters;
+		}
+		wake( push_waiters, not_full );
+		return true;
+	}
+
+	//	after the last push: wakes every consumer waiting in pop
+	void close()
+	{
+		closed.store( true, std::memory_order_release );
+		{
+			std::lock_guard< std::mutex > lock( wait_mutex );
+		}
+		not_empty.notify_all();
+	}
+
+	bool try_push( const T &value )
+	{
+		size_t pos = enqueue_pos.load( std::memory_order_relaxed );
+		cell *c;
+		for( ;; )
+		{
+			c = &cells[pos & mask];
+			size_t seq = c->seq.load( std::memory_order_acquire );
+			ptrdiff_t dif = (ptrdiff_t)seq - (ptrdiff_t)pos;
+			if( dif == 0 )
+			{
+				if( enqueue_pos.compare_exchange_weak( pos, pos + 1, std::memory_order_relaxed ) )
+				{
+					break;
+				}
+			} else if( dif < 0 )
+			{
+				//	full
+				return false;
+			} else
+			{
+				pos = enqueue_pos.load( std::memory_order_relaxed );
+			}
+		}
+		c->data = value;
+		c->seq.store( pos + 1, std::memory_order_release );
+		return true;
+	}
+
+	bool try_pop( T &value )
+	{
+		size_t pos = dequeue_pos.load( std::memory_order_relaxed );
+		cell *c;
+		for( ;; )
+		{
+			c = &cells[pos & mask];
+			size_t seq = c->seq.load( std::memory_order_acquire );
+			ptrdiff_t dif = (ptrdiff_t)seq - (ptrdiff_t)(pos + 1);
+			if( dif == 0 )
+			{
+				if( dequeue_pos.compare_exchange_weak( pos, pos + 1, std::memory_order_relaxed ) )
+				{
+					break;
+				}
+			} else if( dif < 0 )
+			{
+				//	empty
+				return false;
+			} else
+			{
+				pos = dequeue_pos.load( std::memory_order_relaxed );
+			}
+		}
+		value = c->data;
+		c->seq.store( pos + mask + 1, std::memory_order_release );
+		return true;
+	}
+
+private:
+	//	(under wait_mutex) the fence pairs with the one in wake, so either
+	//	the waiter's next try sees the other side's push / pop, or the
+	//	other side sees the waiter
+	void start_waiting( std::atomic< int > &waiters )
+	{
+		++waiters;
+		std::atomic_thread_fence( std::memory_order_seq_cst );
+	}
+
+	void wake( std::atomic< int > &waiters, std::condition_variable &cv )
+	{
+		std::atomic_thread_fence( std::memory_order_seq_cst );
+		if( waiters.load( std::memory_order_relaxed ) > 0 )
+		{
+			//	the waiter holds the lock from its last try until it sleeps
+			{
+				std::lock_guard< std::mutex > lock( wait_mutex );
+			}
+			cv.notify_one();
+		}
+	}
+
+	struct cell
+	{
+		cell() : seq( 0 ), data() {}
+		std::atomic< size_t > seq;
+		T data;
+	};
+	std::vector< cell > cells;
+	size_t mask;
+	//	the two positions live on separate cache lines
+	char pad0[64];
+	std::atomic< size_t > enqueue_pos;
+	char pad1[64];
+	std::atomic< size_t > dequeue_pos;
+	char pad2[64];
+	//	only for sleeping in push / pop
+	std::atomic< int > push_waiters;
+	std::atomic< int > pop_waiters;
+	std::atomic< bool > closed;
+	std::mutex wait_mutex;
+	std::condition_variable not_full;
+	std::condition_variable not_empty;
+};
+
+#endif
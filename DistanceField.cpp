@@ -0,0 +1,869 @@
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <vector>
+
+#include "DistanceField.hpp"
+#include "WorkStealing.hpp"
+
+struct sdf_backend_info
+{
+	sdf_backend backend;
+	const char *name;
+};
+
+static const sdf_backend_info backend_table[] =
+{
+	{ SDF_BACKEND_RADIAL,	"radial" },
+	{ SDF_BACKEND_EDT,		"edt" },
+	{ SDF_BACKEND_8SSEDT,	"8ssedt" },
+	{ SDF_BACKEND_PYRAMID,	"pyramid" },
+	{ SDF_BACKEND_SPIRAL,	"spiral" },
+	{ SDF_BACKEND_COHERENT,	"coherent" },
+	{ SDF_BACKEND_BOUNDARY,	"boundary" },
+	{ SDF_BACKEND_BITPACKED,	"bitpacked" },
+	{ SDF_BACKEND_AAEDT,	"aaedt" },
+	{ SDF_BACKEND_OUTLINE,	"outline" },
+	{ SDF_BACKEND_HYBRID,	"hybrid" },
+	{ SDF_BACKEND_FTSDF,	"ftsdf" },
+	{ SDF_BACKEND_FTBSDF,	"ftbsdf" }
+};
+static const int num_backends = sizeof( backend_table ) / sizeof( backend_table[0] );
+
+bool parse_sdf_backend( const char *name, sdf_backend &backend )
+{
+	for( int i = 0; i < num_backends; ++i )
+	{
+		if( strcmp( name, backend_table[i].name ) == 0 )
+		{
+			backend = backend_table[i].backend;
+			return true;
+		}
+	}
+	return false;
+}
+
+const char* sdf_backend_name( sdf_backend backend )
+{
+	for( int i = 0; i < num_backends; ++i )
+	{
+		if( backend_table[i].backend == backend )
+		{
+			return backend_table[i].name;
+		}
+	}
+	return "unknown";
+}
+
+const char* sdf_backend_list()
+{
+	static std::vector< char > list;
+	if( list.empty() )
+	{
+		for( int i = 0; i < num_backends; ++i )
+		{
+			if( i > 0 )
+			{
+				list.push_back( '|' );
+			}
+			const char *n = backend_table[i].name;
+			list.insert( list.end(), n, n + strlen( n ) );
+		}
+		list.push_back( 0 );
+	}
+	return &list[0];
+}
+
+bool sdf_backend_needs_glyph( sdf_backend backend )
+{
+	return (backend == SDF_BACKEND_OUTLINE) || (backend == SDF_BACKEND_HYBRID) ||
+		(backend == SDF_BACKEND_FTSDF) || (backend == SDF_BACKEND_FTBSDF);
+}
+
+unsigned char encode_SDF_distance(
+		float d2,
+		bool inside,
+		int max_radius )
+{
+	d2 = sqrtf( d2 );
+	if( !inside )
+	{
+		d2 = -d2;
+	}
+	d2 *= 127.5 / max_radius;
+	d2 += 127.5;
+	if( d2 < 0.0 ) d2 = 0.0;
+	if( d2 > 255.0 ) d2 = 255.0;
+	return (unsigned char)(d2 + 0.5);
+}
+
+unsigned char get_SDF_radial_scalar(
+		const unsigned char *fontmap,
+		int w, int h,
+		int x, int y,
+		int max_radius )
+{
+	//	hideous brute force method
+	float d2 = max_radius*max_radius+1.0;
+	unsigned char v = fontmap[x+y*w];
+	for( int radius = 1; (radius <= max_radius) && (radius*radius < d2); ++radius )
+	{
+		int line, lo, hi;
+		//	north
+		line = y - radius;
+		if( (line >= 0) && (line < h) )
+		{
+			lo = x - radius;
+			hi = x + radius;
+			if( lo < 0 ) { lo = 0; }
+			if( hi >= w ) { hi = w-1; }
+			int idx = line * w + lo;
+			for( int i = lo; i <= hi; ++i )
+			{
+				//	check this pixel
+				if( fontmap[idx] != v )
+				{
+					float nx = i - x;
+					float ny = line - y;
+					float nd2 = nx*nx+ny*ny;
+					if( nd2 < d2 )
+					{
+						d2 = nd2;
+					}
+				}
+				//	move on
+				++idx;
+			}
+		}
+		//	south
+		line = y + radius;
+		if( (line >= 0) && (line < h) )
+		{
+			lo = x - radius;
+			hi = x + radius;
+			if( lo < 0 ) { lo = 0; }
+			if( hi >= w ) { hi = w-1; }
+			int idx = line * w + lo;
+			for( int i = lo; i <= hi; ++i )
+			{
+				//	check this pixel
+				if( fontmap[idx] != v )
+				{
+					float nx = i - x;
+					float ny = line - y;
+					float nd2 = nx*nx+ny*ny;
+					if( nd2 < d2 )
+					{
+						d2 = nd2;
+					}
+				}
+				//	move on
+				++idx;
+			}
+		}
+		//	west
+		line = x - radius;
+		if( (line >= 0) && (line < w) )
+		{
+			lo = y - radius + 1;
+			hi = y + radius - 1;
+			if( lo < 0 ) { lo = 0; }
+			if( hi >= h ) { hi = h-1; }
+			int idx = lo * w + line;
+			for( int i = lo; i <= hi; ++i )
+			{
+				//	check this pixel
+				if( fontmap[idx] != v )
+				{
+					float nx = line - x;
+					float ny = i - y;
+					float nd2 = nx*nx+ny*ny;
+					if( nd2 < d2 )
+					{
+						d2 = nd2;
+					}
+				}
+				//	move on
+				idx += w;
+			}
+		}
+		//	east
+		line = x + radius;
+		if( (line >= 0) && (line < w) )
+		{
+			lo = y - radius + 1;
+			hi = y + radius - 1;
+			if( lo < 0 ) { lo = 0; }
+			if( hi >= h ) { hi = h-1; }
+			int idx = lo * w + line;
+			for( int i = lo; i <= hi; ++i )
+			{
+				//	check this pixel
+				if( fontmap[idx] != v )
+				{
+					float nx = line - x;
+					float ny = i - y;
+					float nd2 = nx*nx+ny*ny;
+					if( nd2 < d2 )
+					{
+						d2 = nd2;
+					}
+				}
+				//	move on
+				idx += w;
+			}
+		}
+	}
+	return encode_SDF_distance( d2, v != 0, max_radius );
+}
+
+//	integer division, rounding towards negative infinity
+static inline long long floor_div( long long num, long long den )
+{
+	long long q = num / den;
+	if( (num % den != 0) && ((num < 0) != (den < 0)) )
+	{
+		--q;
+	}
+	return q;
+}
+
+//	Phase 1 of Meijster, Roerdink & Hesselink, "A General Algorithm for
+//	Computing Distance Transforms in Linear Time".  For every pixel in a
+//	sampled row, find the vertical distance to the nearest "on" and the
+//	nearest "off" pixel in its column.  Anything beyond 'cap' is clamped
+//	anyway, so capping keeps the later squares small.  Only the sampled
+//	rows are stored, but every row is visited exactly twice.
+template< typename T >
+void column_distances(
+		const unsigned char *img,
+		int w, int h,
+		const std::vector< int > &ys,
+		int x0, int x1,
+		int cap,
+		T *g_on, T *g_off )
+{
+	int nr = ys.size();
+	int n = x1 - x0;
+	std::vector< int > run_on( n, cap ), run_off( n, cap );
+	//	top down
+	int k = 0;
+	for( int y = 0; (y < h) && (k < nr); ++y )
+	{
+		const unsigned char *row = img + y * w + x0;
+		for( int x = 0; x < n; ++x )
+		{
+			if( row[x] )
+			{
+				run_on[x] = 0;
+				if( run_off[x] < cap ) { ++run_off[x]; }
+			} else
+			{
+				run_off[x] = 0;
+				if( run_on[x] < cap ) { ++run_on[x]; }
+			}
+		}
+		while( (k < nr) && (ys[k] == y) )
+		{
+			T *gn = g_on + k * w + x0;
+			T *gf = g_off + k * w + x0;
+			for( int x = 0; x < n; ++x )
+			{
+				gn[x] = run_on[x];
+				gf[x] = run_off[x];
+			}
+			++k;
+		}
+	}
+	//	bottom up
+	run_on.assign( n, cap );
+	run_off.assign( n, cap );
+	k = nr - 1;
+	for( int y = h - 1; (y >= 0) && (k >= 0); --y )
+	{
+		const unsigned char *row = img + y * w + x0;
+		for( int x = 0; x < n; ++x )
+		{
+			if( row[x] )
+			{
+				run_on[x] = 0;
+				if( run_off[x] < cap ) { ++run_off[x]; }
+			} else
+			{
+				run_off[x] = 0;
+				if( run_on[x] < cap ) { ++run_on[x]; }
+			}
+		}
+		while( (k >= 0) && (ys[k] == y) )
+		{
+			T *gn = g_on + k * w + x0;
+			T *gf = g_off + k * w + x0;
+			for( int x = 0; x < n; ++x )
+			{
+				if( run_on[x] < gn[x] ) { gn[x] = run_on[x]; }
+				if( run_off[x] < gf[x] ) { gf[x] = run_off[x]; }
+			}
+			--k;
+		}
+	}
+}
+
+template void column_distances< int >(
+		const unsigned char *, int, int, const std::vector< int > &,
+		int, int, int, int *, int * );
+template void column_distances< unsigned short >(
+		const unsigned char *, int, int, const std::vector< int > &,
+		int, int, int, unsigned short *, unsigned short * );
+
+//	Phase 2 of Meijster: the lower envelope of the parabolas
+//	f(x,i) = (x-i)^2 + g(i)^2 along one row, giving squared distances.
+void row_distances(
+		const int *g,
+		int w,
+		int *dt,
+		int *s, int *t )
+{
+	int q = 0;
+	s[0] = 0;
+	t[0] = 0;
+	for( int u = 1; u < w; ++u )
+	{
+		//	f(t[q], s[q]) > f(t[q], u)
+		while( q >= 0 )
+		{
+			long long a = t[q] - s[q];
+			long long b = t[q] - u;
+			long long gs = g[s[q]], gu = g[u];
+			if( a*a + gs*gs <= b*b + gu*gu )
+			{
+				break;
+			}
+			--q;
+		}
+		if( q < 0 )
+		{
+			q = 0;
+			s[0] = u;
+		} else
+		{
+			//	(squares of image sized values, so in 64 bits)
+			long long i = s[q];
+			long long gi = g[i], gu = g[u];
+			long long sep = 1 + floor_div(
+					(long long)u*u - i*i + gu*gu - gi*gi,
+					2 * (u - i) );
+			if( sep < w )
+			{
+				++q;
+				s[q] = u;
+				t[q] = sep;
+			}
+		}
+	}
+	for( int u = w - 1; u >= 0; --u )
+	{
+		long long dx = u - s[q];
+		long long gs = g[s[q]];
+		dt[u] = (int)std::min( dx*dx + gs*gs, (long long)INT_MAX );
+		if( u == t[q] )
+		{
+			--q;
+		}
+	}
+}
+
+//	Exact Euclidean distance transform of the whole bitmap, evaluated
+//	only at the sample points.  Each sample gets the squared distance to
+//	the nearest pixel of the opposite value, exactly as the radial search
+//	would find it, so the encoded bytes are identical.  The column pass
+//	is split into bands of columns and the row pass into bands of sampled
+//	rows, each spread over 'jobs' threads; no band depends on another.
+void render_SDF_grid_EDT(
+		const unsigned char *img,
+		int w, int h,
+		const std::vector< int > &xs,
+		const std::vector< int > &ys,
+		int max_radius,
+		int jobs,
+		unsigned char *sdf )
+{
+	const int cap = max_radius + 1;
+	const int clamp_d2 = max_radius * max_radius + 1;
+	int nr = ys.size();
+	int nx = xs.size();
+	std::vector< int > g_on( nr * w ), g_off( nr * w );
+	std::vector< thread_load > load;
+	//	a few bands per thread, columns in whole cache lines
+	int bands = (jobs > 1) ? 4 * jobs : 1;
+	int col_band = std::max( 64, ((w + bands - 1) / bands + 63) & ~63 );
+	std::vector< long long > col_cost( (w + col_band - 1) / col_band, 1 );
+	run_work_stealing( col_cost, jobs,
+			[&]( int b, int )
+			{
+				int x0 = b * col_band;
+				int x1 = std::min( x0 + col_band, w );
+				column_distances( img, w, h, ys, x0, x1, cap, &g_on[0], &g_off[0] );
+			},
+			load );
+	int row_band = std::max( 1, (nr + bands - 1) / bands );
+	std::vector< long long > row_cost( (nr + row_band - 1) / row_band, 1 );
+	run_work_stealing( row_cost, jobs,
+			[&]( int b, int )
+			{
+				std::vector< int > dt_on( w ), dt_off( w ), s( w ), t( w );
+				int j1 = std::min( (b + 1) * row_band, nr );
+				for( int j = b * row_band; j < j1; ++j )
+				{
+					row_distances( &g_on[j * w], w, &dt_on[0], &s[0], &t[0] );
+					row_distances( &g_off[j * w], w, &dt_off[0], &s[0], &t[0] );
+					const unsigned char *row = img + ys[j] * w;
+					for( int i = 0; i < nx; ++i )
+					{
+						int x = xs[i];
+						bool inside = (row[x] != 0);
+						int d2 = inside ? dt_off[x] : dt_on[x];
+						if( d2 > clamp_d2 )
+						{
+							d2 = clamp_d2;
+						}
+						sdf[i + j * nx] = encode_SDF_distance( d2, inside, max_radius );
+					}
+				}
+			},
+			load );
+}
+
+//	8SSEDT (Danielsson / Leymarie & Levine): every pixel carries the
+//	offset to its nearest pixel of the opposite value, and the offsets
+//	are propagated from the 8 neighbours in one forward and one backward
+//	sweep.  This is not exact (the true nearest pixel is occasionally
+//	missed), but the error is a fraction of a pixel.  Inside and outside
+//	share one grid: a neighbour of the opposite value is itself the
+//	candidate, otherwise its own offset is extended.
+struct ssedt_point
+{
+	short dx, dy;
+};
+
+static inline int ssedt_d2( const ssedt_point &p )
+{
+	return p.dx * p.dx + p.dy * p.dy;
+}
+
+//	'none' must be skipped (not extended), or it would slowly walk in
+//	from the border and look like a real pixel.  Since 'none' is also
+//	the largest distance ever kept, every stored offset stays small.
+static inline void ssedt_compare(
+		const ssedt_point *g,
+		const unsigned char *cls,
+		int pitch,
+		ssedt_point &p, int &pd2,
+		int idx, int ox, int oy,
+		short none )
+{
+	int n = idx + ox + oy * pitch;
+	ssedt_point other;
+	if( cls[n] != cls[idx] )
+	{
+		if( cls[n] > 1 )
+		{
+			//	outside the bitmap
+			return;
+		}
+		other.dx = ox;
+		other.dy = oy;
+	} else
+	{
+		other = g[n];
+		if( (other.dx == none) && (other.dy == none) )
+		{
+			return;
+		}
+		other.dx += ox;
+		other.dy += oy;
+	}
+	int od2 = ssedt_d2( other );
+	if( od2 < pd2 )
+	{
+		p = other;
+		pd2 = od2;
+	}
+}
+
+//	g and cls are (w+2) x (h+2), cls is 0 or 1 inside and 2 on the border
+static void ssedt_sweep(
+		ssedt_point *g,
+		const unsigned char *cls,
+		int w, int h,
+		short none )
+{
+	int pitch = w + 2;
+	for( int y = 1; y <= h; ++y )
+	{
+		int idx = y * pitch + 1;
+		for( int x = 1; x <= w; ++x, ++idx )
+		{
+			ssedt_point p = g[idx];
+			int pd2 = ssedt_d2( p );
+			ssedt_compare( g, cls, pitch, p, pd2, idx, -1, 0, none );
+			ssedt_compare( g, cls, pitch, p, pd2, idx, 0, -1, none );
+			ssedt_compare( g, cls, pitch, p, pd2, idx, -1, -1, none );
+			ssedt_compare( g, cls, pitch, p, pd2, idx, 1, -1, none );
+			g[idx] = p;
+		}
+		idx = y * pitch + w;
+		for( int x = w; x >= 1; --x, --idx )
+		{
+			ssedt_point p = g[idx];
+			int pd2 = ssedt_d2( p );
+			ssedt_compare( g, cls, pitch, p, pd2, idx, 1, 0, none );
+			g[idx] = p;
+		}
+	}
+	for( int y = h; y >= 1; --y )
+	{
+		int idx = y * pitch + w;
+		for( int x = w; x >= 1; --x, --idx )
+		{
+			ssedt_point p = g[idx];
+			int pd2 = ssedt_d2( p );
+			ssedt_compare( g, cls, pitch, p, pd2, idx, 1, 0, none );
+			ssedt_compare( g, cls, pitch, p, pd2, idx, 0, 1, none );
+			ssedt_compare( g, cls, pitch, p, pd2, idx, -1, 1, none );
+			ssedt_compare( g, cls, pitch, p, pd2, idx, 1, 1, none );
+			g[idx] = p;
+		}
+		idx = y * pitch + 1;
+		for( int x = 1; x <= w; ++x, ++idx )
+		{
+			ssedt_point p = g[idx];
+			int pd2 = ssedt_d2( p );
+			ssedt_compare( g, cls, pitch, p, pd2, idx, -1, 0, none );
+			g[idx] = p;
+		}
+	}
+}
+
+static void render_SDF_grid_8SSEDT(
+		const unsigned char *img,
+		int w, int h,
+		const std::vector< int > &xs,
+		const std::vector< int > &ys,
+		int max_radius,
+		unsigned char *sdf )
+{
+	//	anything this far away is clamped, and the squares still fit
+	const short far_away = max_radius + 2;
+	const int clamp_d2 = max_radius * max_radius + 1;
+	const ssedt_point none = { far_away, far_away };
+	int pitch = w + 2;
+	std::vector< ssedt_point > g( pitch * (h + 2), none );
+	std::vector< unsigned char > cls( pitch * (h + 2), 2 );
+	for( int y = 0; y < h; ++y )
+	{
+		const unsigned char *row = img + y * w;
+		unsigned char *c = &cls[(y + 1) * pitch + 1];
+		for( int x = 0; x < w; ++x )
+		{
+			c[x] = (row[x] != 0);
+		}
+	}
+	ssedt_sweep( &g[0], &cls[0], w, h, far_away );
+	int nx = xs.size();
+	for( unsigned int j = 0; j < ys.size(); ++j )
+	{
+		const unsigned char *row = img + ys[j] * w;
+		for( int i = 0; i < nx; ++i )
+		{
+			int x = xs[i];
+			int idx = (ys[j] + 1) * pitch + x + 1;
+			int d2 = ssedt_d2( g[idx] );
+			if( d2 > clamp_d2 )
+			{
+				d2 = clamp_d2;
+			}
+			sdf[i + j * nx] = encode_SDF_distance( d2, row[x] != 0, max_radius );
+		}
+	}
+}
+
+void build_edge_mask(
+		const unsigned char *img,
+		int w, int h,
+		int radius,
+		std::vector< unsigned char > &mask )
+{
+	//	mark the pixels that differ from a 4-neighbour (both sides)
+	std::vector< unsigned char > edge( w * h, 0 );
+	for( int y = 0; y < h; ++y )
+	{
+		const unsigned char *row = img + y * w;
+		unsigned char *e = &edge[y * w];
+		for( int x = 0; x + 1 < w; ++x )
+		{
+			if( row[x] != row[x+1] )
+			{
+				e[x] = 1;
+				e[x+1] = 1;
+			}
+		}
+		if( y + 1 < h )
+		{
+			for( int x = 0; x < w; ++x )
+			{
+				if( row[x] != row[x+w] )
+				{
+					e[x] = 1;
+					e[x+w] = 1;
+				}
+			}
+		}
+	}
+	//	dilate horizontally with a running count over [x-radius, x+radius]
+	std::vector< unsigned char > hdil( w * h, 0 );
+	for( int y = 0; y < h; ++y )
+	{
+		const unsigned char *e = &edge[y * w];
+		unsigned char *d = &hdil[y * w];
+		int count = 0;
+		for( int x = 0; (x < radius) && (x < w); ++x )
+		{
+			count += e[x];
+		}
+		for( int x = 0; x < w; ++x )
+		{
+			if( x + radius < w ) { count += e[x + radius]; }
+			if( x - radius - 1 >= 0 ) { count -= e[x - radius - 1]; }
+			d[x] = (count > 0);
+		}
+	}
+	//	then vertically, with one running count per column
+	mask.assign( w * h, 0 );
+	std::vector< int > count( w, 0 );
+	for( int y = 0; (y < radius) && (y < h); ++y )
+	{
+		for( int x = 0; x < w; ++x )
+		{
+			count[x] += hdil[y * w + x];
+		}
+	}
+	for( int y = 0; y < h; ++y )
+	{
+		const unsigned char *add = (y + radius < h) ? &hdil[(y + radius) * w] : NULL;
+		const unsigned char *sub = (y - radius - 1 >= 0) ? &hdil[(y - radius - 1) * w] : NULL;
+		unsigned char *m = &mask[y * w];
+		for( int x = 0; x < w; ++x )
+		{
+			if( add ) { count[x] += add[x]; }
+			if( sub ) { count[x] -= sub[x]; }
+			m[x] = (count[x] > 0);
+		}
+	}
+}
+
+//	Run a per-sample kernel only where it can matter.  If the mask says
+//	there is no edge anywhere in the (2r+1)^2 search window, then every
+//	pixel in it has the sample's value, nothing is found, and the kernel
+//	would return the clamped value anyway.
+static void render_SDF_grid_masked(
+		radial_kernel kernel,
+		const unsigned char *img,
+		int w, int h,
+		const std::vector< int > &xs,
+		const std::vector< int > &ys,
+		int max_radius,
+		unsigned char *sdf )
+{
+	std::vector< unsigned char > mask;
+	build_edge_mask( img, w, h, max_radius, mask );
+	int nx = xs.size();
+	for( unsigned int j = 0; j < ys.size(); ++j )
+	{
+		for( int i = 0; i < nx; ++i )
+		{
+			int idx = xs[i] + ys[j] * w;
+			if( mask[idx] )
+			{
+				sdf[i + j * nx] = kernel( img, w, h, xs[i], ys[j], max_radius );
+			} else
+			{
+				sdf[i + j * nx] = img[idx] ? 255 : 0;
+			}
+		}
+	}
+}
+
+void render_SDF_grid(
+		sdf_backend backend,
+		const unsigned char *img,
+		int w, int h,
+		const std::vector< int > &xs,
+		const std::vector< int > &ys,
+		int max_radius,
+		unsigned char *sdf )
+{
+	switch( backend )
+	{
+	case SDF_BACKEND_EDT:
+	case SDF_BACKEND_HYBRID:
+		render_SDF_grid_EDT( img, w, h, xs, ys, max_radius, 1, sdf );
+		break;
+	case SDF_BACKEND_8SSEDT:
+		render_SDF_grid_8SSEDT( img, w, h, xs, ys, max_radius, sdf );
+		break;
+	case SDF_BACKEND_PYRAMID:
+		render_SDF_grid_pyramid( img, w, h, xs, ys, max_radius, sdf );
+		break;
+	case SDF_BACKEND_SPIRAL:
+		render_SDF_grid_spiral( img, w, h, xs, ys, max_radius, sdf );
+		break;
+	case SDF_BACKEND_COHERENT:
+		render_SDF_grid_coherent( img, w, h, xs, ys, max_radius, sdf );
+		break;
+	case SDF_BACKEND_BOUNDARY:
+		render_SDF_grid_boundary( img, w, h, xs, ys, max_radius, sdf );
+		break;
+	case SDF_BACKEND_BITPACKED:
+		{
+			std::vector< unsigned char > bits;
+			packed_bitmap pb;
+			pack_bitmap( img, w, h, bits, pb );
+			render_SDF_grid_packed( pb, xs, ys, max_radius, sdf );
+		}
+		break;
+	case SDF_BACKEND_AAEDT:
+		render_SDF_grid_AA( img, w, h, xs, ys, max_radius, sdf );
+		break;
+	case SDF_BACKEND_RADIAL:
+	default:
+		render_SDF_grid_masked( get_SDF_radial, img, w, h, xs, ys, max_radius, sdf );
+		break;
+	}
+}
+
+void measure_SDF_error(
+		const unsigned char *img,
+		int w, int h,
+		const std::vector< int > &xs,
+		const std::vector< int > &ys,
+		int max_radius,
+		const unsigned char *sdf,
+		sdf_error_stats &stats )
+{
+	std::vector< unsigned char > ref( xs.size() * ys.size() );
+	if( ref.empty() )
+	{
+		return;
+	}
+	render_SDF_grid( SDF_BACKEND_RADIAL, img, w, h, xs, ys, max_radius, &ref[0] );
+	//	one level of the encoding, in source pixels
+	double level_pixels = max_radius / 127.5;
+	for( unsigned int i = 0; i < ref.size(); ++i )
+	{
+		int e = abs( (int)sdf[i] - (int)ref[i] );
+		if( e > stats.max_levels )
+		{
+			stats.max_levels = e;
+		}
+		stats.sum_levels += e;
+		double ep = e * level_pixels;
+		if( ep > stats.max_pixels )
+		{
+			stats.max_pixels = ep;
+		}
+		stats.sum_pixels += ep;
+	}
+	stats.samples += ref.size();
+}
+
+void print_SDF_error( const sdf_error_stats &stats )
+{
+	if( stats.samples < 1 )
+	{
+		return;
+	}
+	printf( "Error vs the radial reference over %lli samples:\n", stats.samples );
+	printf( "  max %i levels (%1.3f pixels), mean %1.4f levels (%1.4f pixels)\n",
+			stats.max_levels, stats.max_pixels,
+			stats.sum_levels / stats.samples,
+			stats.sum_pixels / stats.samples );
+}
+
+void merge_SDF_error( sdf_error_stats &total, const sdf_error_stats &stats )
+{
+	total.samples += stats.samples;
+	total.max_levels = std::max( total.max_levels, stats.max_levels );
+	total.sum_levels += stats.sum_levels;
+	total.max_pixels = std::max( total.max_pixels, stats.max_pixels );
+	total.sum_pixels += stats.sum_pixels;
+}
+
+void benchmark_SDF_grid(
+		const unsigned char *img,
+		int w, int h,
+		const std::vector< int > &xs,
+		const std::vector< int > &ys,
+		int max_radius,
+		sdf_benchmark &bench )
+{
+	int n = xs.size() * ys.size();
+	if( n < 1 )
+	{
+		return;
+	}
+	std::vector< unsigned char > ref( n ), sdf( n );
+	for( int b = 0; b < SDF_BACKEND_COUNT; ++b )
+	{
+		if( sdf_backend_needs_glyph( (sdf_backend)b ) )
+		{
+			//	needs the glyph itself, not just this bitmap
+			continue;
+		}
+		std::vector< unsigned char > &out = (b == SDF_BACKEND_RADIAL) ? ref : sdf;
+		std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+		render_SDF_grid( (sdf_backend)b, img, w, h, xs, ys, max_radius, &out[0] );
+		std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+		bench.seconds[b] += std::chrono::duration< double >( t1 - t0 ).count();
+		if( b != SDF_BACKEND_RADIAL )
+		{
+			for( int i = 0; i < n; ++i )
+			{
+				bench.mismatches[b] += (sdf[i] != ref[i]);
+			}
+		}
+	}
+	bench.samples += n;
+}
+
+void print_SDF_benchmark( const sdf_benchmark &bench )
+{
+	if( bench.samples < 1 )
+	{
+		return;
+	}
+	printf( "SDF backend benchmark over %lli samples (radial kernel: %s):\n",
+			bench.samples, radial_isa_name() );
+	double ref = bench.seconds[SDF_BACKEND_RADIAL];
+	for( int b = 0; b < SDF_BACKEND_COUNT; ++b )
+	{
+		printf( "  %-10s %9.3f s  %7.2fx  %lli mismatches\n",
+				sdf_backend_name( (sdf_backend)b ),
+				bench.seconds[b],
+				(bench.seconds[b] > 0.0) ? ref / bench.seconds[b] : 0.0,
+				bench.mismatches[b] );
+	}
+}
+
+void merge_SDF_benchmark( sdf_benchmark &total, const sdf_benchmark &bench )
+{
+	total.samples += bench.samples;
+	for( int b = 0; b < SDF_BACKEND_COUNT; ++b )
+	{
+		total.seconds[b] += bench.seconds[b];
+		total.mismatches[b] += bench.mismatches[b];
+	}
+}
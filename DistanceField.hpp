@@ -0,0 +1,314 @@
+#ifndef DISTANCEFIELD_H
+#define DISTANCEFIELD_H
+
+#include <vector>
+
+//	The algorithms that can turn a binary (0 / 255) bitmap into
+//	signed distance samples.  All of them produce the same encoding:
+//	the edge is at 127.5, and the distance is clamped at max_radius.
+//	(aaedt also reads coverage values in between, and outline skips the
+//	bitmap for the glyph's vector outline, see OutlineSDF.hpp.  The ft*
+//	backends are FreeType's, see GlyphSDF.cpp.)
+enum sdf_backend
+{
+	SDF_BACKEND_RADIAL,	//	brute force ring search (the reference)
+	SDF_BACKEND_EDT,	//	exact separable Euclidean distance transform
+	SDF_BACKEND_8SSEDT,	//	approximate two pass sequential (dead reckoning)
+	SDF_BACKEND_PYRAMID,	//	radial search pruned by a min/max mip pyramid
+	SDF_BACKEND_SPIRAL,	//	distance sorted offset table, first hit wins
+	SDF_BACKEND_COHERENT,	//	spiral search seeded by the previous sample
+	SDF_BACKEND_BOUNDARY,	//	boundary pixels bucketed in a uniform grid
+	SDF_BACKEND_BITPACKED,	//	1 bit per pixel rows, searched with clz / ctz
+	SDF_BACKEND_AAEDT,	//	sub-pixel edges from anti-aliased coverage
+	SDF_BACKEND_OUTLINE,	//	exact distance to the glyph's Bezier outline
+	SDF_BACKEND_HYBRID,	//	edt, then the outline near the edge
+	SDF_BACKEND_FTSDF,	//	FreeType's own "sdf" renderer (from the outline)
+	SDF_BACKEND_FTBSDF,	//	FreeType's own "bsdf" renderer (from a texel sized AA bitmap)
+	SDF_BACKEND_COUNT
+};
+
+//	how far an SDF differs from the radial reference (in 0..255 levels
+//	and in source pixels), accumulated over any number of calls
+struct sdf_error_stats
+{
+	sdf_error_stats() : samples( 0 ), max_levels( 0 ),
+		sum_levels( 0.0 ), max_pixels( 0.0 ), sum_pixels( 0.0 ) {}
+	long long samples;
+	int max_levels;
+	double sum_levels;
+	double max_pixels;
+	double sum_pixels;
+};
+
+//	time spent by each backend on the same inputs, and how many of its
+//	samples differ from the radial reference
+struct sdf_benchmark
+{
+	sdf_benchmark() : samples( 0 ), seconds( SDF_BACKEND_COUNT, 0.0 ),
+		mismatches( SDF_BACKEND_COUNT, 0 ) {}
+	long long samples;
+	std::vector< double > seconds;
+	std::vector< long long > mismatches;
+};
+
+//	name <=> backend, returns false if the name is unknown
+bool parse_sdf_backend( const char *name, sdf_backend &backend );
+const char* sdf_backend_name( sdf_backend backend );
+//	a '|' separated list of all backend names, for the usage text
+const char* sdf_backend_list();
+//	true if the backend works from the FreeType glyph, not just a bitmap
+//	(images fall back to edt, and benchmark_SDF_grid leaves it out)
+bool sdf_backend_needs_glyph( sdf_backend backend );
+
+//	convert a squared distance (in source pixels) into the 0..255 encoding
+unsigned char encode_SDF_distance(
+		float d2,
+		bool inside,
+		int max_radius );
+
+//	find the distance from (x,y) to the nearest pixel of the opposite value
+//	(dispatches to the best kernel this CPU supports, see RadialSIMD.cpp)
+unsigned char get_SDF_radial(
+		const unsigned char *fontmap,
+		int w, int h,
+		int x, int y,
+		int max_radius );
+
+//	the individual kernels, all give bit-identical results
+typedef unsigned char (*radial_kernel)(
+		const unsigned char *fontmap,
+		int w, int h,
+		int x, int y,
+		int max_radius );
+unsigned char get_SDF_radial_scalar( const unsigned char *fontmap, int w, int h, int x, int y, int max_radius );
+unsigned char get_SDF_radial_sse2( const unsigned char *fontmap, int w, int h, int x, int y, int max_radius );
+unsigned char get_SDF_radial_avx2( const unsigned char *fontmap, int w, int h, int x, int y, int max_radius );
+
+//	force a kernel ("auto", "scalar", "sse2" or "avx2"), false if unavailable;
+//	call it before any threads are rendering
+bool set_radial_isa( const char *name );
+const char* radial_isa_name();
+
+//	Mark every pixel that has an edge (a pair of differing 4-neighbours)
+//	within its (2*radius+1)^2 window.  Samples off the mask are saturated.
+void build_edge_mask(
+		const unsigned char *img,
+		int w, int h,
+		int radius,
+		std::vector< unsigned char > &mask );
+
+//	Compute the SDF for every sample point (xs[i], ys[j]) of the w x h
+//	bitmap, storing them row major in sdf (xs.size() * ys.size() bytes).
+//	Both xs and ys must be non-decreasing and inside the bitmap.  (The
+//	outline and ft* backends have no bitmap to work from, they fall back
+//	to radial, and hybrid does only its edt pass.)
+void render_SDF_grid(
+		sdf_backend backend,
+		const unsigned char *img,
+		int w, int h,
+		const std::vector< int > &xs,
+		const std::vector< int > &ys,
+		int max_radius,
+		unsigned char *sdf );
+
+//	Phase 1 of Meijster's EDT for columns [x0,x1): the vertical distance
+//	(capped at cap) to the nearest "on" / "off" pixel, at every row in
+//	ys (ascending).  g_on / g_off hold ys.size() rows of w values; T is
+//	int or unsigned short (DistanceField.cpp)
+template< typename T >
+void column_distances(
+		const unsigned char *img,
+		int w, int h,
+		const std::vector< int > &ys,
+		int x0, int x1,
+		int cap,
+		T *g_on, T *g_off );
+
+//	Phase 2 of Meijster's EDT along one row, dt[x] = min (x-i)^2 + g[i]^2
+//	(worked out in 64 bits, saturated at INT_MAX for very wide rows),
+//	s and t are w ints of scratch space
+void row_distances(
+		const int *g,
+		int w,
+		int *dt,
+		int *s, int *t );
+
+//	render_SDF_grid for the edt backend, with both Meijster passes split
+//	over 'jobs' threads (the result doesn't depend on the count)
+void render_SDF_grid_EDT(
+		const unsigned char *img,
+		int w, int h,
+		const std::vector< int > &xs,
+		const std::vector< int > &ys,
+		int max_radius,
+		int jobs,
+		unsigned char *sdf );
+
+//	Exact EDT of the whole w x h bitmap, with the signed distance box
+//	filtered down to out_w x out_h texels (point sampled along an axis
+//	shorter than out_w / out_h) (ImageEDT.cpp)
+void render_SDF_image_box(
+		const unsigned char *img,
+		int w, int h,
+		int out_w, int out_h,
+		int max_radius,
+		int jobs,
+		unsigned char *sdf );
+
+//	render_SDF_grid in cache sized blocks on 'jobs' threads (0 means one
+//	per hardware thread), same result (TiledGrid.cpp); edt is threaded
+//	by bands of its passes instead of blocks
+void render_SDF_grid_tiled(
+		sdf_backend backend,
+		const unsigned char *img,
+		int w, int h,
+		const std::vector< int > &xs,
+		const std::vector< int > &ys,
+		int max_radius,
+		int jobs,
+		unsigned char *sdf );
+
+//	the pyramid search (DistancePyramid.cpp), exact
+void render_SDF_grid_pyramid(
+		const unsigned char *img,
+		int w, int h,
+		const std::vector< int > &xs,
+		const std::vector< int > &ys,
+		int max_radius,
+		unsigned char *sdf );
+
+//	one entry of the spiral search table
+struct spiral_offset
+{
+	int dx, dy;
+	int d2;
+};
+
+//	all offsets with 0 < d2 <= max_radius^2, nearest first (built once
+//	per radius, then shared)
+const std::vector< spiral_offset > &get_spiral_table( int max_radius );
+
+//	copy a bitmap into the middle of a larger one, surrounded by 'fill'
+void pad_bitmap(
+		const unsigned char *img,
+		int w, int h,
+		int border,
+		unsigned char fill,
+		std::vector< unsigned char > &padded );
+
+//	the spiral search (SpiralSearch.cpp), exact
+void render_SDF_grid_spiral(
+		const unsigned char *img,
+		int w, int h,
+		const std::vector< int > &xs,
+		const std::vector< int > &ys,
+		int max_radius,
+		unsigned char *sdf );
+
+//	the spiral search, bounded by the previous sample in the row, exact
+void render_SDF_grid_coherent(
+		const unsigned char *img,
+		int w, int h,
+		const std::vector< int > &xs,
+		const std::vector< int > &ys,
+		int max_radius,
+		unsigned char *sdf );
+
+//	nearest boundary pixel queries (BoundaryGrid.cpp), exact
+void render_SDF_grid_boundary(
+		const unsigned char *img,
+		int w, int h,
+		const std::vector< int > &xs,
+		const std::vector< int > &ys,
+		int max_radius,
+		unsigned char *sdf );
+
+//	A w x h bitmap whose pixels are all off, except for a bw x bh block
+//	of 1 bit per pixel rows (MSB first) at (ox,oy).  'bits' points to the
+//	top row and 'pitch' may be negative, just like an FT_Bitmap.
+struct packed_bitmap
+{
+	int w, h;
+	int ox, oy;
+	int bw, bh;
+	int pitch;
+	const unsigned char *bits;
+};
+
+//	pack a 0 / 255 bitmap (1/8th the memory), pb points into 'bits'
+void pack_bitmap(
+		const unsigned char *img,
+		int w, int h,
+		std::vector< unsigned char > &bits,
+		packed_bitmap &pb );
+
+//	the bit packed search (BitPacked.cpp), exact
+unsigned char get_SDF_packed(
+		const packed_bitmap &pb,
+		int x, int y,
+		int max_radius );
+
+void render_SDF_grid_packed(
+		const packed_bitmap &pb,
+		const std::vector< int > &xs,
+		const std::vector< int > &ys,
+		int max_radius,
+		unsigned char *sdf );
+
+//	Signed distance (in pixels, positive inside) of every pixel of a
+//	coverage bitmap, with sub-pixel edges, clamped a little past
+//	max_radius (AntiAliasedEDT.cpp)
+void AA_distance_field(
+		const unsigned char *img,
+		int w, int h,
+		int max_radius,
+		std::vector< float > &field );
+
+//	bilinear lookup in a distance field, (x,y) in pixel centre units
+float sample_distance_field(
+		const std::vector< float > &field,
+		int w, int h,
+		float x, float y );
+
+//	encode a signed distance (positive inside)
+unsigned char encode_SDF_signed( float d, int max_radius );
+
+void render_SDF_grid_AA(
+		const unsigned char *img,
+		int w, int h,
+		const std::vector< int > &xs,
+		const std::vector< int > &ys,
+		int max_radius,
+		unsigned char *sdf );
+
+//	recompute the samples with get_SDF_radial and accumulate the error
+void measure_SDF_error(
+		const unsigned char *img,
+		int w, int h,
+		const std::vector< int > &xs,
+		const std::vector< int > &ys,
+		int max_radius,
+		const unsigned char *sdf,
+		sdf_error_stats &stats );
+
+void print_SDF_error( const sdf_error_stats &stats );
+
+//	fold one (e.g. per thread) set of stats into another
+void merge_SDF_error( sdf_error_stats &total, const sdf_error_stats &stats );
+
+//	run every bitmap backend on the same input, timing each one and
+//	checking it against the radial reference (the glyph backends are
+//	the caller's)
+void benchmark_SDF_grid(
+		const unsigned char *img,
+		int w, int h,
+		const std::vector< int > &xs,
+		const std::vector< int > &ys,
+		int max_radius,
+		sdf_benchmark &bench );
+
+void print_SDF_benchmark( const sdf_benchmark &bench );
+
+void merge_SDF_benchmark( sdf_benchmark &total, const sdf_benchmark &bench );
+
+#endif
@@ -0,0 +1,186 @@
+//	Hierarchical (min/max mip pyramid) version of the radial search.
+//	Level k of the pyramid holds the min and max of every 2^k x 2^k block,
+//	so a block whose min and max both equal the sample's value cannot
+//	hold an opposite pixel, and is never opened.  The remaining blocks
+//	are visited nearest first (by their lower bound distance), which
+//	jumps straight to the first candidate and stops as soon as no block
+//	can beat the best pixel found.  The result is exact.
+
+#include <algorithm>
+#include <vector>
+
+#include "DistanceField.hpp"
+
+struct minmax_level
+{
+	int w, h;
+	std::vector< unsigned char > lo, hi;
+};
+
+//	a block waiting to be opened, ordered by its lower bound
+struct pyramid_node
+{
+	int d2;
+	int level;
+	int bx, by;
+	bool operator<( const pyramid_node &n ) const
+	{
+		//	reversed, so the std heap functions give the smallest first
+		return d2 > n.d2;
+	}
+};
+
+static void build_pyramid(
+		const unsigned char *img,
+		int w, int h,
+		int levels,
+		std::vector< minmax_level > &pyr )
+{
+	pyr.resize( levels + 1 );
+	pyr[0].w = w;
+	pyr[0].h = h;
+	pyr[0].lo.assign( img, img + w * h );
+	pyr[0].hi = pyr[0].lo;
+	for( int k = 1; k <= levels; ++k )
+	{
+		const minmax_level &src = pyr[k-1];
+		minmax_level &dst = pyr[k];
+		dst.w = (src.w + 1) >> 1;
+		dst.h = (src.h + 1) >> 1;
+		dst.lo.resize( dst.w * dst.h );
+		dst.hi.resize( dst.w * dst.h );
+		for( int by = 0; by < dst.h; ++by )
+		{
+			int y0 = by * 2;
+			int y1 = std::min( y0 + 1, src.h - 1 );
+			for( int bx = 0; bx < dst.w; ++bx )
+			{
+				int x0 = bx * 2;
+				int x1 = std::min( x0 + 1, src.w - 1 );
+				int a = y0 * src.w, b = y1 * src.w;
+				unsigned char lo = std::min(
+						std::min( src.lo[a + x0], src.lo[a + x1] ),
+						std::min( src.lo[b + x0], src.lo[b + x1] ) );
+				unsigned char hi = std::max(
+						std::max( src.hi[a + x0], src.hi[a + x1] ),
+						std::max( src.hi[b + x0], src.hi[b + x1] ) );
+				dst.lo[by * dst.w + bx] = lo;
+				dst.hi[by * dst.w + bx] = hi;
+			}
+		}
+	}
+}
+
+//	squared distance from (x,y) to the nearest pixel of a block
+static inline int block_d2(
+		int x, int y,
+		int level, int bx, int by,
+		int w, int h )
+{
+	int x0 = bx << level;
+	int y0 = by << level;
+	int x1 = std::min( x0 + (1 << level), w ) - 1;
+	int y1 = std::min( y0 + (1 << level), h ) - 1;
+	int dx = (x < x0) ? (x0 - x) : ((x > x1) ? (x - x1) : 0);
+	int dy = (y < y0) ? (y0 - y) : ((y > y1) ? (y - y1) : 0);
+	return dx*dx + dy*dy;
+}
+
+static unsigned char get_SDF_pyramid(
+		const std::vector< minmax_level > &pyr,
+		int x, int y,
+		int max_radius,
+		std::vector< pyramid_node > &heap )
+{
+	const int w = pyr[0].w;
+	const int h = pyr[0].h;
+	const unsigned char v = pyr[0].lo[x + y * w];
+	int best = max_radius * max_radius + 1;
+	int top = pyr.size() - 1;
+	heap.clear();
+	//	seed with the (few) top level blocks covering the search window
+	int bx0 = std::max( x - max_radius, 0 ) >> top;
+	int bx1 = std::min( x + max_radius, w - 1 ) >> top;
+	int by0 = std::max( y - max_radius, 0 ) >> top;
+	int by1 = std::min( y + max_radius, h - 1 ) >> top;
+	for( int by = by0; by <= by1; ++by )
+	{
+		for( int bx = bx0; bx <= bx1; ++bx )
+		{
+			int idx = bx + by * pyr[top].w;
+			if( (pyr[top].lo[idx] != v) || (pyr[top].hi[idx] != v) )
+			{
+				pyramid_node n = { block_d2( x, y, top, bx, by, w, h ), top, bx, by };
+				if( n.d2 < best )
+				{
+					heap.push_back( n );
+					std::push_heap( heap.begin(), heap.end() );
+				}
+			}
+		}
+	}
+	while( !heap.empty() )
+	{
+		std::pop_heap( heap.begin(), heap.end() );
+		pyramid_node n = heap.back();
+		heap.pop_back();
+		if( n.d2 >= best )
+		{
+			break;
+		}
+		if( n.level == 0 )
+		{
+			//	an opposite pixel, and the nearest one left
+			best = n.d2;
+			break;
+		}
+		//	open the block
+		int k = n.level - 1;
+		const minmax_level &lev = pyr[k];
+		for( int cy = n.by * 2; cy <= std::min( n.by * 2 + 1, lev.h - 1 ); ++cy )
+		{
+			for( int cx = n.bx * 2; cx <= std::min( n.bx * 2 + 1, lev.w - 1 ); ++cx )
+			{
+				int idx = cx + cy * lev.w;
+				if( (lev.lo[idx] != v) || (lev.hi[idx] != v) )
+				{
+					pyramid_node c = { block_d2( x, y, k, cx, cy, w, h ), k, cx, cy };
+					if( c.d2 < best )
+					{
+						heap.push_back( c );
+						std::push_heap( heap.begin(), heap.end() );
+					}
+				}
+			}
+		}
+	}
+	return encode_SDF_distance( best, v != 0, max_radius );
+}
+
+void render_SDF_grid_pyramid(
+		const unsigned char *img,
+		int w, int h,
+		const std::vector< int > &xs,
+		const std::vector< int > &ys,
+		int max_radius,
+		unsigned char *sdf )
+{
+	//	stop once a block is at least as big as the search radius, so
+	//	only a 2x2 or 3x3 set of top blocks ever covers the window
+	int levels = 0;
+	while( ((1 << levels) < max_radius) && (((w - 1) >> levels) > 0 || ((h - 1) >> levels) > 0) )
+	{
+		++levels;
+	}
+	std::vector< minmax_level > pyr;
+	build_pyramid( img, w, h, levels, pyr );
+	std::vector< pyramid_node > heap;
+	int nx = xs.size();
+	for( unsigned int j = 0; j < ys.size(); ++j )
+	{
+		for( int i = 0; i < nx; ++i )
+		{
+			sdf[i + j * nx] = get_SDF_pyramid( pyr, xs[i], ys[j], max_radius, heap );
+		}
+	}
+}
@@ -0,0 +1,519 @@
+//	The glyph SDF generators: one entry per backend, each split into
+//	the FreeType work and the distance computation.  Most of them
+//	rasterize the glyph 'scaler' times too large and sample that bitmap.
+//	The vector ones read the outline instead, and ftsdf / ftbsdf hand
+//	the whole job to FreeType's own "sdf" and "bsdf" renderers.
+
+#include <chrono>
+#include <cstring>
+#include <vector>
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+#include FT_MODULE_H
+#include FT_OUTLINE_H
+
+#include "GlyphSDF.hpp"
+
+void expand_glyph_raster(
+		const glyph_raster &raster,
+		int scaler,
+		std::vector< unsigned char > &buf,
+		int &sw, int &sh )
+{
+	int w = raster.w;
+	int h = raster.h;
+	int p = raster.pitch;
+	//	oversize the holding buffer so I can smooth it!
+	sw = w + scaler * 8; // * 4;
+	sh = h + scaler * 8; // * 4;
+	buf.assign( sw * sh, 0 );
+	const unsigned char *bits = raster.bits.empty() ? NULL : &raster.bits[0];
+	for( int j = 0; j < h; ++j )
+	{
+		for( int i = 0; i < w; ++i )
+		{
+			int value = raster.gray ? bits[j * p + i] :
+					255 * ((bits[j * p + (i>>3)] >> (7 - (i & 7))) & 1);
+			buf[i + scaler*2 + (j + scaler*2) * sw] = value;
+		}
+	}
+}
+
+void glyph_sample_points(
+		const sdf_glyph &glyph,
+		int scaler,
+		std::vector< int > &xs,
+		std::vector< int > &ys )
+{
+	xs.resize( glyph.width );
+	ys.resize( glyph.height );
+	for( int i = 0; i < glyph.width; ++i )
+	{
+		xs[i] = i*scaler + (scaler/2);
+	}
+	for( int j = 0; j < glyph.height; ++j )
+	{
+		ys[j] = j*scaler + (scaler/2);
+	}
+}
+
+void glyph_texel_centres(
+		const sdf_glyph &glyph,
+		int scaler,
+		std::vector< double > &xs,
+		std::vector< double > &ys )
+{
+	xs.resize( glyph.width );
+	ys.resize( glyph.height );
+	for( int i = 0; i < glyph.width; ++i )
+	{
+		xs[i] = glyph.bitmap_left + (i + 0.5 - 2) * scaler;
+	}
+	for( int j = 0; j < glyph.height; ++j )
+	{
+		ys[j] = glyph.bitmap_top - (j + 0.5 - 2) * scaler;
+	}
+}
+
+bool get_glyph_bitmap_box(
+		FT_GlyphSlot slot,
+		FT_Render_Mode render_mode,
+		int &left, int &top,
+		int &w, int &h )
+{
+	if( slot->format != FT_GLYPH_FORMAT_OUTLINE )
+	{
+		if( FT_Render_Glyph( slot, render_mode ) != 0 )
+		{
+			return false;
+		}
+		left = slot->bitmap_left;
+		top = slot->bitmap_top;
+		w = slot->bitmap.width;
+		h = slot->bitmap.rows;
+		return true;
+	}
+	FT_BBox cbox;
+	FT_Outline_Get_CBox( &slot->outline, &cbox );
+	get_cbox_bitmap_box( cbox, render_mode, left, top, w, h );
+	return true;
+}
+
+void get_cbox_bitmap_box(
+		const FT_BBox &cbox,
+		FT_Render_Mode render_mode,
+		int &left, int &top,
+		int &w, int &h )
+{
+	//	whole pixels, then the 26.6 remainders
+	FT_Pos x0 = cbox.xMin >> 6, x1 = cbox.xMax >> 6;
+	FT_Pos y0 = cbox.yMin >> 6, y1 = cbox.yMax >> 6;
+	FT_Pos fx0 = cbox.xMin & 63, fx1 = cbox.xMax & 63;
+	FT_Pos fy0 = cbox.yMin & 63, fy1 = cbox.yMax & 63;
+	if( render_mode == FT_RENDER_MODE_MONO )
+	{
+		//	the pixels whose centres are covered, but never less than one
+		x0 += (fx0 + 31) >> 6;
+		x1 += (fx1 + 32) >> 6;
+		if( x0 == x1 )
+		{
+			if( ((fx0 + 31) & 63) - 31 + ((fx1 + 32) & 63) - 32 < 0 )
+			{
+				x0 -= 1;
+			} else
+			{
+				x1 += 1;
+			}
+		}
+		y0 += (fy0 + 31) >> 6;
+		y1 += (fy1 + 32) >> 6;
+		if( y0 == y1 )
+		{
+			if( ((fy0 + 31) & 63) - 31 + ((fy1 + 32) & 63) - 32 < 0 )
+			{
+				y0 -= 1;
+			} else
+			{
+				y1 += 1;
+			}
+		}
+	} else
+	{
+		//	every pixel touched
+		x1 += (fx1 + 63) >> 6;
+		y1 += (fy1 + 63) >> 6;
+	}
+	left = x0;
+	top = y1;
+	w = x1 - x0;
+	h = y1 - y0;
+}
+
+//	copy the slot's bitmap, top row first
+static void copy_glyph_bitmap( const FT_Bitmap &bitmap, glyph_raster &raster )
+{
+	raster.w = bitmap.width;
+	raster.h = bitmap.rows;
+	raster.gray = (bitmap.pixel_mode == FT_PIXEL_MODE_GRAY);
+	raster.pitch = (bitmap.pitch < 0) ? -bitmap.pitch : bitmap.pitch;
+	raster.bits.resize( raster.pitch * raster.h );
+	for( int j = 0; j < raster.h; ++j )
+	{
+		//	FreeType's "up flow" bitmaps start at the bottom row
+		int row = (bitmap.pitch < 0) ? (raster.h - 1 - j) : j;
+		memcpy( &raster.bits[j * raster.pitch],
+				bitmap.buffer + row * raster.pitch, raster.pitch );
+	}
+}
+
+static bool render_glyph_bitmap(
+		const sdf_generator &self,
+		FT_Face &ft_face,
+		const sdf_glyph &glyph,
+		glyph_raster &raster )
+{
+	if( (FT_Load_Glyph( ft_face, glyph.glyph_index, 0 ) != 0) ||
+		(FT_Render_Glyph( ft_face->glyph, self.render_mode ) != 0) )
+	{
+		return false;
+	}
+	copy_glyph_bitmap( ft_face->glyph->bitmap, raster );
+	return true;
+}
+
+static bool load_glyph_outline(
+		FT_Face &ft_face,
+		const sdf_glyph &glyph,
+		glyph_raster &raster )
+{
+	return (FT_Load_Glyph( ft_face, glyph.glyph_index, 0 ) == 0) &&
+		(ft_face->glyph->format == FT_GLYPH_FORMAT_OUTLINE) &&
+		decompose_outline( ft_face->glyph->outline, raster.outline );
+}
+
+//	the bitmap backends
+static bool prepare_bitmap(
+		const sdf_generator &self,
+		FT_Face &ft_face,
+		const sdf_glyph &glyph,
+		int /*scaler*/,
+		bool /*need_bitmap*/,
+		glyph_raster &raster )
+{
+	return render_glyph_bitmap( self, ft_face, glyph, raster );
+}
+
+static void generate_bitmap(
+		const sdf_generator &self,
+		const glyph_raster &raster,
+		const sdf_glyph &glyph,
+		int scaler,
+		std::vector< unsigned char > &sdf )
+{
+	std::vector< unsigned char > buf;
+	int sw, sh;
+	expand_glyph_raster( raster, scaler, buf, sw, sh );
+	std::vector< int > sample_x, sample_y;
+	glyph_sample_points( glyph, scaler, sample_x, sample_y );
+	sdf.resize( glyph.width * glyph.height );
+	render_SDF_grid( self.backend, &buf[0], sw, sh,
+			sample_x, sample_y, 2*scaler, &sdf[0] );
+}
+
+//	the bit packed search reads the mono bitmap as is
+static void generate_packed(
+		const sdf_generator &/*self*/,
+		const glyph_raster &raster,
+		const sdf_glyph &glyph,
+		int scaler,
+		std::vector< unsigned char > &sdf )
+{
+	packed_bitmap pb;
+	pb.w = raster.w + scaler * 8;
+	pb.h = raster.h + scaler * 8;
+	pb.ox = pb.oy = scaler*2;
+	pb.bw = raster.w;
+	pb.bh = raster.h;
+	pb.pitch = raster.pitch;
+	pb.bits = raster.bits.empty() ? NULL : &raster.bits[0];
+	std::vector< int > sample_x, sample_y;
+	glyph_sample_points( glyph, scaler, sample_x, sample_y );
+	sdf.resize( glyph.width * glyph.height );
+	render_SDF_grid_packed( pb, sample_x, sample_y, 2*scaler, &sdf[0] );
+}
+
+//	the anti-aliased EDT, sampled at the exact texel centres
+static void generate_AA(
+		const sdf_generator &/*self*/,
+		const glyph_raster &raster,
+		const sdf_glyph &glyph,
+		int scaler,
+		std::vector< unsigned char > &sdf )
+{
+	std::vector< unsigned char > buf;
+	int sw, sh;
+	expand_glyph_raster( raster, scaler, buf, sw, sh );
+	std::vector< float > field;
+	AA_distance_field( &buf[0], sw, sh, 2*scaler, field );
+	int sdfw = glyph.width;
+	sdf.resize( glyph.width * glyph.height );
+	for( int j = 0; j < glyph.height; ++j )
+	{
+		for( int i = 0; i < sdfw; ++i )
+		{
+			float d = sample_distance_field( field, sw, sh,
+					(i + 0.5f) * scaler - 0.5f, (j + 0.5f) * scaler - 0.5f );
+			sdf[i + j * sdfw] = encode_SDF_signed( d, 2*scaler );
+		}
+	}
+}
+
+//	the vector backend only needs the (hinted) outline
+static bool prepare_outline(
+		const sdf_generator &self,
+		FT_Face &ft_face,
+		const sdf_glyph &glyph,
+		int /*scaler*/,
+		bool need_bitmap,
+		glyph_raster &raster )
+{
+	if( !load_glyph_outline( ft_face, glyph, raster ) )
+	{
+		return false;
+	}
+	if( !need_bitmap && (self.backend == SDF_BACKEND_OUTLINE) )
+	{
+		return true;
+	}
+	if( FT_Render_Glyph( ft_face->glyph, self.render_mode ) != 0 )
+	{
+		return false;
+	}
+	copy_glyph_bitmap( ft_face->glyph->bitmap, raster );
+	return true;
+}
+
+static void generate_outline(
+		const sdf_generator &/*self*/,
+		const glyph_raster &raster,
+		const sdf_glyph &glyph,
+		int scaler,
+		std::vector< unsigned char > &sdf )
+{
+	std::vector< double > outline_x, outline_y;
+	glyph_texel_centres( glyph, scaler, outline_x, outline_y );
+	sdf.resize( glyph.width * glyph.height );
+	render_SDF_outline( raster.outline, outline_x, outline_y, 2*scaler, &sdf[0] );
+}
+
+static void generate_hybrid(
+		const sdf_generator &self,
+		const glyph_raster &raster,
+		const sdf_glyph &glyph,
+		int scaler,
+		std::vector< unsigned char > &sdf )
+{
+	generate_bitmap( self, raster, glyph, scaler, sdf );
+	//	the raster samples sit half a pixel off the texel centres, so
+	//	allow a bit over a pixel of slack
+	std::vector< double > outline_x, outline_y;
+	glyph_texel_centres( glyph, scaler, outline_x, outline_y );
+	refine_SDF_outline( raster.outline, outline_x, outline_y,
+			2*scaler, 1.5, &sdf[0] );
+}
+
+//	FreeType's SDF (spread pixels each way, edge at 128) into the tile,
+//	where tile texel (i,j) is SDF pixel (i - dx, j - dy).  If inside is
+//	given (one flag per texel), it overrules FreeType's sign.
+static void copy_freetype_SDF(
+		const FT_Bitmap &bitmap,
+		int dx, int dy,
+		double spread,
+		const sdf_glyph &glyph,
+		int max_radius,
+		const unsigned char *inside,
+		std::vector< unsigned char > &tile )
+{
+	int pitch = (bitmap.pitch < 0) ? -bitmap.pitch : bitmap.pitch;
+	tile.assign( glyph.width * glyph.height, 0 );
+	for( int j = 0; j < glyph.height; ++j )
+	{
+		int v = j - dy;
+		if( (v < 0) || (v >= (int)bitmap.rows) )
+		{
+			continue;
+		}
+		int row = (bitmap.pitch < 0) ? ((int)bitmap.rows - 1 - v) : v;
+		const unsigned char *src = bitmap.buffer + row * pitch;
+		for( int i = 0; i < glyph.width; ++i )
+		{
+			int u = i - dx;
+			if( (u >= 0) && (u < (int)bitmap.width) )
+			{
+				float d = (src[u] - 128.0f) / 128.0f * spread;
+				if( (inside != NULL) && ((d > 0.0f) != (inside[i + j * glyph.width] != 0)) )
+				{
+					d = -d;
+				}
+				tile[i + j * glyph.width] = encode_SDF_signed( d, max_radius );
+			}
+		}
+	}
+}
+
+//	load the same hinted outline as the others (and keep its segments,
+//	if asked), then shrink it by 'scaler' with the tile's top left corner
+//	at the origin, so FreeType renders it at texel size
+static bool load_texel_outline(
+		FT_Face &ft_face,
+		const sdf_glyph &glyph,
+		int scaler,
+		glyph_outline *segments )
+{
+	if( (FT_Load_Glyph( ft_face, glyph.glyph_index, 0 ) != 0) ||
+		(ft_face->glyph->format != FT_GLYPH_FORMAT_OUTLINE) )
+	{
+		return false;
+	}
+	FT_Outline &outline = ft_face->glyph->outline;
+	if( (segments != NULL) && !decompose_outline( outline, *segments ) )
+	{
+		return false;
+	}
+	FT_Matrix shrink;
+	shrink.xx = shrink.yy = FT_DivFix( 1, scaler );
+	shrink.xy = shrink.yx = 0;
+	FT_Outline_Transform( &outline, &shrink );
+	FT_Outline_Translate( &outline,
+			-FT_MulDiv( glyph.bitmap_left - 2*scaler, 64, scaler ),
+			-FT_MulDiv( glyph.bitmap_top + 2*scaler, 64, scaler ) );
+	return true;
+}
+
+//	FreeType's "sdf" renderer, straight from the outline at texel size
+static bool prepare_freetype_SDF(
+		const sdf_generator &self,
+		FT_Face &ft_face,
+		const sdf_glyph &glyph,
+		int scaler,
+		bool need_bitmap,
+		glyph_raster &raster )
+{
+	if( need_bitmap && !render_glyph_bitmap( self, ft_face, glyph, raster ) )
+	{
+		return false;
+	}
+	std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+	glyph_outline segments;
+	if( !load_texel_outline( ft_face, glyph, scaler, &segments ) )
+	{
+		return false;
+	}
+	//	the spread is in output pixels, i.e. texels
+	FT_Int spread = 2;
+	if( (FT_Property_Set( ft_face->glyph->library, "sdf", "spread", &spread ) != 0) ||
+		(FT_Render_Glyph( ft_face->glyph, FT_RENDER_MODE_SDF ) != 0) )
+	{
+		return false;
+	}
+	//	FreeType occasionally gets the sign of a texel wrong, so take it
+	//	from the outline's own fill rule, as the vector backends do
+	std::vector< double > outline_x, outline_y;
+	glyph_texel_centres( glyph, scaler, outline_x, outline_y );
+	std::vector< unsigned char > inside;
+	outline_inside( segments, outline_x, outline_y, inside );
+	//	SDF pixel (u,v) is centred at (left + u + 1/2, top - v - 1/2),
+	//	texel (i,j) at (i + 1/2, -j - 1/2)
+	copy_freetype_SDF( ft_face->glyph->bitmap,
+			ft_face->glyph->bitmap_left, -ft_face->glyph->bitmap_top,
+			spread * scaler, glyph, 2*scaler, &inside[0], raster.tile );
+	raster.seconds = std::chrono::duration< double >(
+			std::chrono::steady_clock::now() - t0 ).count();
+	return true;
+}
+
+//	FreeType's "bsdf" renderer, from an anti-aliased bitmap at texel
+//	size (it reads the coverage for the sub-pixel edge, like aaedt)
+static bool prepare_freetype_BSDF(
+		const sdf_generator &self,
+		FT_Face &ft_face,
+		const sdf_glyph &glyph,
+		int scaler,
+		bool need_bitmap,
+		glyph_raster &raster )
+{
+	if( need_bitmap && !render_glyph_bitmap( self, ft_face, glyph, raster ) )
+	{
+		return false;
+	}
+	if( !load_texel_outline( ft_face, glyph, scaler, NULL ) )
+	{
+		return false;
+	}
+	std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+	//	the spread is in bitmap pixels, i.e. texels
+	FT_Int spread = 2;
+	if( (FT_Property_Set( ft_face->glyph->library, "bsdf", "spread", &spread ) != 0) ||
+		(FT_Render_Glyph( ft_face->glyph, FT_RENDER_MODE_NORMAL ) != 0) )
+	{
+		return false;
+	}
+	if( (ft_face->glyph->bitmap.width == 0) || (ft_face->glyph->bitmap.rows == 0) )
+	{
+		//	(bsdf refuses empty bitmaps) nothing inside, all far outside
+		raster.tile.assign( glyph.width * glyph.height, 0 );
+	} else if( FT_Render_Glyph( ft_face->glyph, FT_RENDER_MODE_SDF ) != 0 )
+	{
+		return false;
+	} else
+	{
+		copy_freetype_SDF( ft_face->glyph->bitmap,
+				ft_face->glyph->bitmap_left, -ft_face->glyph->bitmap_top,
+				spread * scaler, glyph, 2*scaler, NULL, raster.tile );
+	}
+	raster.seconds = std::chrono::duration< double >(
+			std::chrono::steady_clock::now() - t0 ).count();
+	return true;
+}
+
+static void generate_tile(
+		const sdf_generator &/*self*/,
+		const glyph_raster &raster,
+		const sdf_glyph &/*glyph*/,
+		int /*scaler*/,
+		std::vector< unsigned char > &sdf )
+{
+	sdf = raster.tile;
+}
+
+static const sdf_generator generator_table[] =
+{
+	{ SDF_BACKEND_RADIAL,		FT_RENDER_MODE_MONO,	16,	prepare_bitmap,		generate_bitmap },
+	{ SDF_BACKEND_EDT,			FT_RENDER_MODE_MONO,	16,	prepare_bitmap,		generate_bitmap },
+	{ SDF_BACKEND_8SSEDT,		FT_RENDER_MODE_MONO,	16,	prepare_bitmap,		generate_bitmap },
+	{ SDF_BACKEND_PYRAMID,		FT_RENDER_MODE_MONO,	16,	prepare_bitmap,		generate_bitmap },
+	{ SDF_BACKEND_SPIRAL,		FT_RENDER_MODE_MONO,	16,	prepare_bitmap,		generate_bitmap },
+	{ SDF_BACKEND_COHERENT,		FT_RENDER_MODE_MONO,	16,	prepare_bitmap,		generate_bitmap },
+	{ SDF_BACKEND_BOUNDARY,		FT_RENDER_MODE_MONO,	16,	prepare_bitmap,		generate_bitmap },
+	{ SDF_BACKEND_BITPACKED,	FT_RENDER_MODE_MONO,	16,	prepare_bitmap,		generate_packed },
+	//	coverage carries the sub-pixel edge, so far fewer pixels will do
+	{ SDF_BACKEND_AAEDT,		FT_RENDER_MODE_NORMAL,	4,	prepare_bitmap,		generate_AA },
+	{ SDF_BACKEND_OUTLINE,		FT_RENDER_MODE_MONO,	16,	prepare_outline,	generate_outline },
+	{ SDF_BACKEND_HYBRID,		FT_RENDER_MODE_MONO,	16,	prepare_outline,	generate_hybrid },
+	{ SDF_BACKEND_FTSDF,		FT_RENDER_MODE_MONO,	16,	prepare_freetype_SDF,	generate_tile },
+	{ SDF_BACKEND_FTBSDF,		FT_RENDER_MODE_MONO,	16,	prepare_freetype_BSDF,	generate_tile }
+};
+static const int num_generators = sizeof( generator_table ) / sizeof( generator_table[0] );
+
+const sdf_generator &get_sdf_generator( sdf_backend backend )
+{
+	for( int i = 0; i < num_generators; ++i )
+	{
+		if( generator_table[i].backend == backend )
+		{
+			return generator_table[i];
+		}
+	}
+	return generator_table[0];
+}
@@ -0,0 +1,113 @@
+#ifndef GLYPHSDF_H
+#define GLYPHSDF_H
+
+#include <vector>
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+#include "DistanceField.hpp"
+#include "OutlineSDF.hpp"
+
+struct sdf_glyph
+{
+	int ID;
+	int width, height;
+	int x, y;
+	float xoff, yoff;
+	float xadv;
+	//	FreeType glyph index, so the render pass needn't map the ID again
+	int glyph_index;
+	//	where the oversampled bitmap sits relative to the glyph origin
+	int bitmap_left, bitmap_top;
+};
+
+//	whatever a generator pulled out of the FT_GlyphSlot, so the rest of
+//	the work needs no FreeType (and can run on any thread)
+struct glyph_raster
+{
+	glyph_raster() : w( 0 ), h( 0 ), pitch( 0 ), gray( false ), seconds( 0.0 ) {}
+	//	the bitmap, copied top row first
+	int w, h;
+	int pitch;
+	//	1 bit per pixel (FT_RENDER_MODE_MONO) or 1 byte of coverage
+	bool gray;
+	std::vector< unsigned char > bits;
+	//	the vector backends' input (and --msdf's)
+	glyph_outline outline;
+	//	a tile FreeType already turned into an SDF (ftsdf / ftbsdf)
+	std::vector< unsigned char > tile;
+	//	time spent computing distances inside FreeType
+	double seconds;
+};
+
+//	One way of turning a glyph into its SDF tile (glyph.width x
+//	glyph.height in the usual 0..255 encoding).  New backends only need
+//	an entry in the table in GlyphSDF.cpp.
+struct sdf_generator
+{
+	sdf_backend backend;
+	//	how the glyphs are rendered, and the oversampling that suits it
+	FT_Render_Mode render_mode;
+	int default_scaler;
+	//	The FreeType side (runs on the thread that owns the face).  The
+	//	glyph's bitmap must be kept whenever need_bitmap is set, for the
+	//	--measure-error / --benchmark references.
+	bool (*prepare)(
+			const sdf_generator &self,
+			FT_Face &ft_face,
+			const sdf_glyph &glyph,
+			int scaler,
+			bool need_bitmap,
+			glyph_raster &raster );
+	//	and the rest
+	void (*generate)(
+			const sdf_generator &self,
+			const glyph_raster &raster,
+			const sdf_glyph &glyph,
+			int scaler,
+			std::vector< unsigned char > &sdf );
+};
+
+const sdf_generator &get_sdf_generator( sdf_backend backend );
+
+//	The size and position of the bitmap FT_Render_Glyph would make of the
+//	loaded glyph, worked out from the outline's control box (the same
+//	rounding FreeType uses) so nothing needs to be rasterized.  Glyphs
+//	that aren't outlines get rendered.
+bool get_glyph_bitmap_box(
+		FT_GlyphSlot slot,
+		FT_Render_Mode render_mode,
+		int &left, int &top,
+		int &w, int &h );
+
+//	the same, from the outline's control box (in 26.6 pixels)
+void get_cbox_bitmap_box(
+		const FT_BBox &cbox,
+		FT_Render_Mode render_mode,
+		int &left, int &top,
+		int &w, int &h );
+
+//	the glyph's bitmap as 0..255 bytes, with 2*scaler pixels of padding
+//	(sw x sh, the same layout the sample points refer to)
+void expand_glyph_raster(
+		const glyph_raster &raster,
+		int scaler,
+		std::vector< unsigned char > &buf,
+		int &sw, int &sh );
+
+//	the bitmap pixel each texel samples
+void glyph_sample_points(
+		const sdf_glyph &glyph,
+		int scaler,
+		std::vector< int > &xs,
+		std::vector< int > &ys );
+
+//	the exact texel centres, in the outline's pixels (y up)
+void glyph_texel_centres(
+		const sdf_glyph &glyph,
+		int scaler,
+		std::vector< double > &xs,
+		std::vector< double > &ys );
+
+#endif
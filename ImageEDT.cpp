@@ -0,0 +1,112 @@
+//	Image mode with one exact distance transform over the whole source.
+//	Meijster's column pass runs over every row (the column distances are
+//	capped at max_radius+1, so they fit in 16 bits), then every source
+//	row gets its row pass, and the signed distance of each pixel is
+//	averaged into the output texel it falls in.  The cost is O(w*h) no
+//	matter how large max_radius gets, and the box filter anti-aliases
+//	the result instead of point sampling it.  An axis with fewer source
+//	pixels than texels has nothing to average, so it is point sampled.
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+#include <vector>
+
+#include "DistanceField.hpp"
+#include "WorkStealing.hpp"
+
+//	the source pixels [lo, hi) that land in texel i of out (out of n
+//	source pixels), or the one nearest its centre if none do
+static void box_span( int i, int n, int out, int &lo, int &hi )
+{
+	lo = ((long long)i * n + out - 1) / out;
+	hi = ((long long)(i + 1) * n + out - 1) / out;
+	if( hi <= lo )
+	{
+		lo = ((long long)(2 * i + 1) * n) / (2 * out);
+		hi = lo + 1;
+	}
+}
+
+void render_SDF_image_box(
+		const unsigned char *img,
+		int w, int h,
+		int out_w, int out_h,
+		int max_radius,
+		int jobs,
+		unsigned char *sdf )
+{
+	if( (out_w < 1) || (out_h < 1) || (w < 1) || (h < 1) )
+	{
+		return;
+	}
+	if( jobs < 1 )
+	{
+		jobs = std::thread::hardware_concurrency();
+	}
+	const int cap = std::min( max_radius + 1, 65535 );
+	const int clamp_d2 = max_radius * max_radius + 1;
+	//	column distances to the nearest "on" / "off" pixel, on every row
+	std::vector< int > all_rows( h );
+	for( int y = 0; y < h; ++y )
+	{
+		all_rows[y] = y;
+	}
+	std::vector< unsigned short > g_on( w * h ), g_off( w * h );
+	std::vector< thread_load > load;
+	//	in bands of whole cache lines, a few per thread
+	int bands = 4 * jobs;
+	int col_band = std::max( 64, ((w + bands - 1) / bands + 63) & ~63 );
+	std::vector< long long > col_cost( (w + col_band - 1) / col_band, 1 );
+	run_work_stealing( col_cost, jobs,
+			[&]( int b, int )
+			{
+				int x0 = b * col_band;
+				int x1 = std::min( x0 + col_band, w );
+				column_distances( img, w, h, all_rows, x0, x1, cap, &g_on[0], &g_off[0] );
+			},
+			load );
+	//	the source columns every output column averages
+	std::vector< int > col_lo( out_w ), col_hi( out_w );
+	for( int i = 0; i < out_w; ++i )
+	{
+		box_span( i, w, out_w, col_lo[i], col_hi[i] );
+	}
+	//	then one output row (and its band of source rows) per task
+	std::vector< long long > cost( out_h, 1 );
+	run_work_stealing( cost, jobs,
+			[&]( int j, int )
+			{
+				int y0, y1;
+				box_span( j, h, out_h, y0, y1 );
+				std::vector< int > gi( w ), dt_on( w ), dt_off( w ), s( w ), t( w );
+				std::vector< double > sum( out_w, 0.0 ), dist( w );
+				for( int y = y0; y < y1; ++y )
+				{
+					for( int x = 0; x < w; ++x ) { gi[x] = g_on[y * w + x]; }
+					row_distances( &gi[0], w, &dt_on[0], &s[0], &t[0] );
+					for( int x = 0; x < w; ++x ) { gi[x] = g_off[y * w + x]; }
+					row_distances( &gi[0], w, &dt_off[0], &s[0], &t[0] );
+					const unsigned char *row = img + y * w;
+					for( int x = 0; x < w; ++x )
+					{
+						dist[x] = row[x] ?
+								sqrt( (double)std::min( dt_off[x], clamp_d2 ) ) :
+								-sqrt( (double)std::min( dt_on[x], clamp_d2 ) );
+					}
+					for( int i = 0; i < out_w; ++i )
+					{
+						for( int x = col_lo[i]; x < col_hi[i]; ++x )
+						{
+							sum[i] += dist[x];
+						}
+					}
+				}
+				for( int i = 0; i < out_w; ++i )
+				{
+					float mean = sum[i] / ((double)(col_hi[i] - col_lo[i]) * (y1 - y0));
+					sdf[i + j * out_w] = encode_SDF_distance( mean * mean, mean > 0.0f, max_radius );
+				}
+			},
+			load );
+}
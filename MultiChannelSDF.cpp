@@ -0,0 +1,426 @@
+//	Multi-channel signed distance fields (after Viktor Chlumsky's
+//	msdfgen).  Every outline segment gets a colour, a subset of R, G, B,
+//	such that the two segments meeting at a sharp corner never share
+//	two channels.  Each channel then stores the signed pseudo-distance
+//	(the distance to the segment's tangent line past its end points)
+//	to the nearest segment of that colour.  The median of the three
+//	channels reproduces the corner exactly after bilinear filtering,
+//	where a plain SDF rounds it off.
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "DistanceField.hpp"
+#include "OutlineSDF.hpp"
+
+static const int edge_cyan = EDGE_GREEN | EDGE_BLUE;
+static const int edge_magenta = EDGE_RED | EDGE_BLUE;
+static const int edge_yellow = EDGE_RED | EDGE_GREEN;
+
+//	the next colour in the cycle (avoiding two of 'banned' channels)
+static void switch_color( int &color, int banned )
+{
+	int combined = color & banned;
+	if( (combined == EDGE_RED) || (combined == EDGE_GREEN) || (combined == EDGE_BLUE) )
+	{
+		color = combined ^ EDGE_WHITE;
+		return;
+	}
+	if( (color == 0) || (color == EDGE_WHITE) )
+	{
+		color = edge_cyan;
+		return;
+	}
+	//	cyan -> magenta -> yellow -> cyan
+	int shifted = color << 1;
+	color = (shifted | (shifted >> 3)) & EDGE_WHITE;
+}
+
+//	do the directions (end of one segment, start of the next) meet at a
+//	corner sharper than the threshold?
+static bool is_corner( double ax, double ay, double bx, double by, double cross_threshold )
+{
+	double la = sqrt( ax*ax + ay*ay );
+	double lb = sqrt( bx*bx + by*by );
+	if( (la == 0.0) || (lb == 0.0) )
+	{
+		return false;
+	}
+	ax /= la;
+	ay /= la;
+	bx /= lb;
+	by /= lb;
+	return (ax*bx + ay*by <= 0.0) || (fabs( ax*by - ay*bx ) > cross_threshold);
+}
+
+//	the piece of a segment between t0 and t1 (by de Casteljau)
+static outline_segment sub_segment( const outline_segment &seg, double t0, double t1 )
+{
+	outline_segment out = seg;
+	int n = seg.order + 1;
+	//	split at t1 and keep the front, then at t0 / t1 and keep the back
+	double x[4], y[4];
+	for( int i = 0; i < n; ++i )
+	{
+		x[i] = seg.x[i];
+		y[i] = seg.y[i];
+	}
+	for( int pass = 0; pass < 2; ++pass )
+	{
+		double t = (pass == 0) ? t1 : ((t1 > 0.0) ? t0 / t1 : 0.0);
+		double px[4], py[4];
+		for( int i = 0; i < n; ++i )
+		{
+			px[i] = x[i];
+			py[i] = y[i];
+		}
+		double fx[4], fy[4], bx[4], by[4];
+		for( int level = 0; level < n; ++level )
+		{
+			fx[level] = px[0];
+			fy[level] = py[0];
+			bx[n - 1 - level] = px[n - 1 - level];
+			by[n - 1 - level] = py[n - 1 - level];
+			for( int i = 0; i + 1 < n - level; ++i )
+			{
+				px[i] += (px[i+1] - px[i]) * t;
+				py[i] += (py[i+1] - py[i]) * t;
+			}
+		}
+		for( int i = 0; i < n; ++i )
+		{
+			x[i] = (pass == 0) ? fx[i] : bx[i];
+			y[i] = (pass == 0) ? fy[i] : by[i];
+		}
+	}
+	for( int i = 0; i < n; ++i )
+	{
+		out.x[i] = x[i];
+		out.y[i] = y[i];
+	}
+	return out;
+}
+
+//	msdfgen's "simple" edge colouring, contour by contour
+static void color_outline_edges( glyph_outline &glyph, double angle_threshold )
+{
+	double cross_threshold = sin( angle_threshold );
+	std::vector< outline_segment > colored;
+	colored.reserve( glyph.segments.size() );
+	unsigned int first = 0;
+	while( first < glyph.segments.size() )
+	{
+		unsigned int last = first;
+		while( (last < glyph.segments.size()) &&
+				(glyph.segments[last].contour == glyph.segments[first].contour) )
+		{
+			++last;
+		}
+		std::vector< outline_segment > edges( glyph.segments.begin() + first,
+				glyph.segments.begin() + last );
+		int m = edges.size();
+		std::vector< int > corners;
+		for( int i = 0; i < m; ++i )
+		{
+			double ax, ay, bx, by;
+			segment_direction( edges[(i + m - 1) % m], 1.0, ax, ay );
+			segment_direction( edges[i], 0.0, bx, by );
+			if( is_corner( ax, ay, bx, by, cross_threshold ) )
+			{
+				corners.push_back( i );
+			}
+		}
+		if( corners.empty() )
+		{
+			//	smooth all the way round, one plain distance will do
+			for( int i = 0; i < m; ++i )
+			{
+				edges[i].color = EDGE_WHITE;
+			}
+		} else if( corners.size() == 1 )
+		{
+			//	a "teardrop": three colours, white in the middle
+			int color = EDGE_WHITE;
+			int colors[3];
+			switch_color( color, 0 );
+			colors[0] = color;
+			colors[1] = EDGE_WHITE;
+			switch_color( color, 0 );
+			colors[2] = color;
+			int corner = corners[0];
+			if( m < 3 )
+			{
+				//	not enough segments for three colours, split them up
+				std::vector< outline_segment > parts;
+				for( int i = 0; i < m; ++i )
+				{
+					const outline_segment &e = edges[(corner + i) % m];
+					parts.push_back( sub_segment( e, 0.0, 1.0 / 3.0 ) );
+					parts.push_back( sub_segment( e, 1.0 / 3.0, 2.0 / 3.0 ) );
+					parts.push_back( sub_segment( e, 2.0 / 3.0, 1.0 ) );
+				}
+				edges.swap( parts );
+				corner = 0;
+				m = edges.size();
+			}
+			for( int i = 0; i < m; ++i )
+			{
+				//	-1, 0 or +1, symmetrical around the middle of the contour
+				int third = (int)(3.0 + 2.875 * i / (m - 1) - 1.4375 + 0.5) - 3;
+				edges[(corner + i) % m].color = colors[1 + third];
+			}
+		} else
+		{
+			//	a new colour for every run between corners, and the last
+			//	one must differ from the first too
+			int spline = 0;
+			int corner_count = corners.size();
+			int start = corners[0];
+			int color = EDGE_WHITE;
+			switch_color( color, 0 );
+			int initial_color = color;
+			for( int i = 0; i < m; ++i )
+			{
+				int index = (start + i) % m;
+				if( (spline + 1 < corner_count) && (corners[spline + 1] == index) )
+				{
+					++spline;
+					switch_color( color, (spline == corner_count - 1) ? initial_color : 0 );
+				}
+				edges[index].color = color;
+			}
+		}
+		colored.insert( colored.end(), edges.begin(), edges.end() );
+		first = last;
+	}
+	glyph.segments.swap( colored );
+}
+
+//	signed distance (positive on the right of the segment's direction,
+//	which is inside for TrueType contours), and how orthogonal the
+//	segment is to the direction of the sample (to break ties at corners)
+static void signed_segment_distance(
+		const outline_segment &seg,
+		double px, double py,
+		double &distance,
+		double &ortho,
+		double &t )
+{
+	double d2 = segment_distance2( seg, px, py, &t );
+	double qx, qy, dx, dy;
+	segment_point( seg, t, qx, qy );
+	segment_direction( seg, t, dx, dy );
+	double vx = px - qx;
+	double vy = py - qy;
+	double cross = dx*vy - dy*vx;
+	distance = (cross > 0.0) ? -sqrt( d2 ) : sqrt( d2 );
+	double len = sqrt( (dx*dx + dy*dy) * (vx*vx + vy*vy) );
+	ortho = (len > 0.0) ? fabs( cross ) / len : 1.0;
+}
+
+//	past an end point, the distance to the tangent line there instead
+static double pseudo_distance(
+		const outline_segment &seg,
+		double px, double py,
+		double distance,
+		double t )
+{
+	if( (t > 0.0) && (t < 1.0) )
+	{
+		return distance;
+	}
+	double dx, dy;
+	segment_direction( seg, t, dx, dy );
+	double len = sqrt( dx*dx + dy*dy );
+	if( len == 0.0 )
+	{
+		return distance;
+	}
+	dx /= len;
+	dy /= len;
+	int e = (t <= 0.0) ? 0 : seg.order;
+	double ax = px - seg.x[e];
+	double ay = py - seg.y[e];
+	double along = ax*dx + ay*dy;
+	if( (t <= 0.0) ? (along < 0.0) : (along > 0.0) )
+	{
+		double pseudo = ax*dy - ay*dx;
+		if( fabs( pseudo ) <= fabs( distance ) )
+		{
+			return pseudo;
+		}
+	}
+	return distance;
+}
+
+static double median( double a, double b, double c )
+{
+	return std::max( std::min( a, b ), std::min( std::max( a, b ), c ) );
+}
+
+//	Would interpolating from texel a to its neighbour b make the median
+//	cross the edge where neither texel says it should?  (msdfgen's clash
+//	test, on distances in units of the full range.)  Only the texel
+//	further from the edge is flagged.
+static bool detect_clash( const double *a, const double *b, double threshold )
+{
+	double a0 = a[0], a1 = a[1], a2 = a[2];
+	double b0 = b[0], b1 = b[1], b2 = b[2];
+	//	order the channels by how much they change, biggest first
+	if( fabs( b0 - a0 ) < fabs( b1 - a1 ) )
+	{
+		std::swap( a0, a1 );
+		std::swap( b0, b1 );
+	}
+	if( fabs( b1 - a1 ) < fabs( b2 - a2 ) )
+	{
+		std::swap( a1, a2 );
+		std::swap( b1, b2 );
+		if( fabs( b0 - a0 ) < fabs( b1 - a1 ) )
+		{
+			std::swap( a0, a1 );
+			std::swap( b0, b1 );
+		}
+	}
+	return (fabs( b1 - a1 ) >= threshold) &&
+			!((b0 == b1) && (b0 == b2)) &&
+			(fabs( a2 ) >= fabs( b2 ));
+}
+
+void render_MSDF_outline(
+		const glyph_outline &outline,
+		const std::vector< double > &xs,
+		const std::vector< double > &ys,
+		int max_radius,
+		unsigned char *rgb )
+{
+	int nx = xs.size();
+	int ny = ys.size();
+	if( (nx < 1) || (ny < 1) )
+	{
+		return;
+	}
+	//	msdfgen's default: anything sharper than ~8 degrees off straight
+	glyph_outline glyph = outline;
+	color_outline_edges( glyph, 3.0 );
+	std::vector< unsigned char > inside;
+	outline_inside( glyph, xs, ys, inside );
+	segment_grid grid;
+	build_segment_grid( glyph, xs, ys, max_radius, max_radius, grid );
+
+	double sign = glyph.reversed ? -1.0 : 1.0;
+	double far = max_radius + 1.0;
+	std::vector< double > field( nx * ny * 3 );
+	std::vector< int > near;
+	for( int j = 0; j < ny; ++j )
+	{
+		for( int i = 0; i < nx; ++i )
+		{
+			double px = xs[i];
+			double py = ys[j];
+			bool in = (inside[i + j * nx] != 0);
+			find_near_segments( grid, px, py, max_radius, near );
+			//	the nearest segment for each channel, and over all
+			int best_seg[3] = { -1, -1, -1 };
+			double best_d[3] = { far, far, far };
+			double best_o[3] = { 0.0, 0.0, 0.0 };
+			double best_t[3] = { 0.0, 0.0, 0.0 };
+			double best_s[3] = { 0.0, 0.0, 0.0 };
+			double nearest = far;
+			for( unsigned int n = 0; n < near.size(); ++n )
+			{
+				double worst = std::max( best_d[0], std::max( best_d[1], best_d[2] ) );
+				if( segment_box_distance2( grid, near[n], px, py ) > worst * worst )
+				{
+					continue;
+				}
+				const outline_segment &seg = glyph.segments[near[n]];
+				double d, o, t;
+				signed_segment_distance( seg, px, py, d, o, t );
+				double ad = fabs( d );
+				nearest = std::min( nearest, ad );
+				for( int c = 0; c < 3; ++c )
+				{
+					if( !(seg.color & (1 << c)) )
+					{
+						continue;
+					}
+					//	equally near (a shared corner), the more orthogonal wins
+					if( (ad < best_d[c] - 1e-9) ||
+						((ad < best_d[c] + 1e-9) && (o > best_o[c])) )
+					{
+						best_seg[c] = near[n];
+						best_d[c] = ad;
+						best_o[c] = o;
+						best_t[c] = t;
+						best_s[c] = d;
+					}
+				}
+			}
+			double channel[3];
+			for( int c = 0; c < 3; ++c )
+			{
+				if( best_seg[c] < 0 )
+				{
+					channel[c] = in ? far : -far;
+				} else
+				{
+					channel[c] = sign * pseudo_distance( glyph.segments[best_seg[c]],
+							px, py, best_s[c], best_t[c] );
+				}
+			}
+			//	where the median disagrees with the true inside / outside
+			//	(overlapping contours, or a clash), fall back to the plain SDF
+			if( (median( channel[0], channel[1], channel[2] ) > 0.0) != in )
+			{
+				channel[0] = channel[1] = channel[2] = in ? nearest : -nearest;
+			}
+			for( int c = 0; c < 3; ++c )
+			{
+				//	as encoded: +-0.5 at max_radius
+				field[(i + j * nx) * 3 + c] = std::min( 0.5, std::max( -0.5,
+						channel[c] / (2.0 * max_radius) ) );
+			}
+		}
+	}
+	//	flatten the texels whose channels clash with a neighbour's (the
+	//	threshold is one texel's worth of distance, more along diagonals)
+	double texel = (nx > 1) ? fabs( xs[1] - xs[0] ) : ((ny > 1) ? fabs( ys[1] - ys[0] ) : 1.0);
+	double threshold = 1.001 * texel / (2.0 * max_radius);
+	std::vector< int > clashes;
+	for( int j = 0; j < ny; ++j )
+	{
+		for( int i = 0; i < nx; ++i )
+		{
+			const double *a = &field[(i + j * nx) * 3];
+			bool clash = false;
+			for( int dj = -1; (dj <= 1) && !clash; ++dj )
+			{
+				for( int di = -1; (di <= 1) && !clash; ++di )
+				{
+					if( ((di == 0) && (dj == 0)) ||
+						(i + di < 0) || (i + di >= nx) || (j + dj < 0) || (j + dj >= ny) )
+					{
+						continue;
+					}
+					double t = ((di != 0) && (dj != 0)) ? threshold * sqrt( 2.0 ) : threshold;
+					clash = detect_clash( a, &field[(i + di + (j + dj) * nx) * 3], t );
+				}
+			}
+			if( clash )
+			{
+				clashes.push_back( i + j * nx );
+			}
+		}
+	}
+	for( unsigned int k = 0; k < clashes.size(); ++k )
+	{
+		double *a = &field[clashes[k] * 3];
+		a[0] = a[1] = a[2] = median( a[0], a[1], a[2] );
+	}
+	for( int i = 0; i < nx * ny * 3; ++i )
+	{
+		rgb[i] = encode_SDF_signed( field[i] * 2.0 * max_radius, max_radius );
+	}
+}
@@ -0,0 +1,97 @@
+#include <ft2build.h>
+#include FT_FREETYPE_H
+#include FT_GLYPH_H
+#include FT_OUTLINE_H
+
+#include "GlyphSDF.hpp"
+#include "OutlineCache.hpp"
+
+bool init_outline_cache(
+		const FT_Face &ft_face,
+		outline_cache &cache )
+{
+	free_outline_cache( cache );
+	if( !FT_IS_SCALABLE( ft_face ) || (ft_face->units_per_EM == 0) )
+	{
+		return false;
+	}
+	cache.units_per_EM = ft_face->units_per_EM;
+	cache.glyphs.assign( ft_face->num_glyphs, NULL );
+	cache.bytes = cache.glyphs.capacity() * sizeof( FT_Glyph );
+	return true;
+}
+
+bool add_cached_glyph(
+		outline_cache &cache,
+		int char_id,
+		int glyph_index,
+		FT_GlyphSlot slot )
+{
+	if( (glyph_index < 0) || (glyph_index >= (int)cache.glyphs.size()) ||
+		(slot->format != FT_GLYPH_FORMAT_OUTLINE) )
+	{
+		return false;
+	}
+	if( cache.glyphs[glyph_index] == NULL )
+	{
+		FT_Glyph glyph;
+		if( FT_Get_Glyph( slot, &glyph ) != 0 )
+		{
+			return false;
+		}
+		cache.glyphs[glyph_index] = glyph;
+		const FT_Outline &outline = ((FT_OutlineGlyph)glyph)->outline;
+		cache.bytes += sizeof( FT_OutlineGlyphRec ) +
+				outline.n_points * (sizeof( FT_Vector ) + sizeof( char )) +
+				outline.n_contours * sizeof( short );
+	}
+	cache.char_ids.push_back( char_id );
+	cache.glyph_indices.push_back( glyph_index );
+	cache.bytes += 2 * sizeof( int );
+	return true;
+}
+
+void free_outline_cache( outline_cache &cache )
+{
+	for( unsigned int i = 0; i < cache.glyphs.size(); ++i )
+	{
+		if( cache.glyphs[i] != NULL )
+		{
+			FT_Done_Glyph( cache.glyphs[i] );
+		}
+	}
+	cache.glyphs.clear();
+	cache.char_ids.clear();
+	cache.glyph_indices.clear();
+	cache.units_per_EM = 0;
+	cache.bytes = 0;
+}
+
+FT_Fixed outline_cache_scale(
+		const outline_cache &cache,
+		int pixel_size )
+{
+	//	what FT_Set_Pixel_Sizes would set as the x / y_scale
+	return FT_DivFix( pixel_size * 64, cache.units_per_EM );
+}
+
+void get_cached_bitmap_box(
+		const outline_cache &cache,
+		int glyph_index,
+		int pixel_size,
+		FT_Render_Mode render_mode,
+		int &left, int &top,
+		int &w, int &h )
+{
+	//	FT_MulFix rounds monotonically, so the control box of the scaled
+	//	outline is just the scaled control box, no need to transform a copy
+	FT_BBox units;
+	FT_Outline_Get_CBox( &((FT_OutlineGlyph)cache.glyphs[glyph_index])->outline, &units );
+	FT_Fixed scale = outline_cache_scale( cache, pixel_size );
+	FT_BBox cbox;
+	cbox.xMin = FT_MulFix( units.xMin, scale );
+	cbox.yMin = FT_MulFix( units.yMin, scale );
+	cbox.xMax = FT_MulFix( units.xMax, scale );
+	cbox.yMax = FT_MulFix( units.yMax, scale );
+	get_cbox_bitmap_box( cbox, render_mode, left, top, w, h );
+}
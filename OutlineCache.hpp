@@ -0,0 +1,58 @@
+#ifndef OUTLINECACHE_H
+#define OUTLINECACHE_H
+
+#include <cstddef>
+#include <vector>
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+#include FT_GLYPH_H
+
+//	Every glyph a font render needs, loaded once in font units (no
+//	hinting) with FT_Get_Glyph, so each trial of the size search is just
+//	a scale.  Nothing is changed once it's filled in, so any number of
+//	threads may read it, and none of them needs the FT_Face.
+struct outline_cache
+{
+	outline_cache() : units_per_EM( 0 ), bytes( 0 ) {}
+	FT_UShort units_per_EM;
+	//	the characters found (in render list order), and their glyphs
+	std::vector< int > char_ids;
+	std::vector< int > glyph_indices;
+	//	indexed by glyph index, NULL for glyphs no character uses
+	std::vector< FT_Glyph > glyphs;
+	//	memory held by the cache
+	size_t bytes;
+};
+
+//	Returns false for fonts without scalable outlines, which must keep
+//	loading glyphs at every size.
+bool init_outline_cache(
+		const FT_Face &ft_face,
+		outline_cache &cache );
+
+//	keep the glyph just loaded (with FT_LOAD_NO_SCALE) into the slot
+bool add_cached_glyph(
+		outline_cache &cache,
+		int char_id,
+		int glyph_index,
+		FT_GlyphSlot slot );
+
+void free_outline_cache( outline_cache &cache );
+
+//	the 16.16 factor from font units to 26.6 pixels at pixel_size
+FT_Fixed outline_cache_scale(
+		const outline_cache &cache,
+		int pixel_size );
+
+//	the bitmap box (as FT_Render_Glyph would make it) of glyph_index
+//	scaled to pixel_size, without hinting
+void get_cached_bitmap_box(
+		const outline_cache &cache,
+		int glyph_index,
+		int pixel_size,
+		FT_Render_Mode render_mode,
+		int &left, int &top,
+		int &w, int &h );
+
+#endif
@@ -0,0 +1,587 @@
+//	Signed distance straight from the glyph's vector outline.  The
+//	FT_Outline is split into lines and quadratic / cubic Beziers, the
+//	segments are bucketed into a uniform grid (one cell per max_radius,
+//	so a sample only ever looks at the 3x3 cells around it), and each
+//	sample gets the true Euclidean distance to the nearest segment.
+//	Quadratics are solved exactly (a cubic in t), cubics by Newton
+//	iterations from a few starting points.  The sign comes from the
+//	winding number along each row of samples, so nothing is rasterized.
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "DistanceField.hpp"
+#include "OutlineSDF.hpp"
+
+//	FT_Outline_Decompose callbacks
+struct decompose_state
+{
+	glyph_outline *glyph;
+	double x, y;
+	int contour;
+};
+
+static int add_move_to( const FT_Vector *to, void *user )
+{
+	decompose_state &s = *(decompose_state*)user;
+	s.x = to->x / 64.0;
+	s.y = to->y / 64.0;
+	++s.contour;
+	return 0;
+}
+
+static void add_segment( decompose_state &s, int order, const FT_Vector **pts )
+{
+	outline_segment seg;
+	seg.order = order;
+	seg.contour = s.contour;
+	seg.color = EDGE_WHITE;
+	seg.x[0] = s.x;
+	seg.y[0] = s.y;
+	for( int i = 0; i < order; ++i )
+	{
+		seg.x[i+1] = pts[i]->x / 64.0;
+		seg.y[i+1] = pts[i]->y / 64.0;
+	}
+	s.x = seg.x[order];
+	s.y = seg.y[order];
+	//	FreeType closes every contour with a line, which may be empty
+	if( (order == 1) && (seg.x[0] == seg.x[1]) && (seg.y[0] == seg.y[1]) )
+	{
+		return;
+	}
+	s.glyph->segments.push_back( seg );
+}
+
+static int add_line_to( const FT_Vector *to, void *user )
+{
+	const FT_Vector *pts[1] = { to };
+	add_segment( *(decompose_state*)user, 1, pts );
+	return 0;
+}
+
+static int add_conic_to( const FT_Vector *control, const FT_Vector *to, void *user )
+{
+	const FT_Vector *pts[2] = { control, to };
+	add_segment( *(decompose_state*)user, 2, pts );
+	return 0;
+}
+
+static int add_cubic_to( const FT_Vector *control1, const FT_Vector *control2,
+		const FT_Vector *to, void *user )
+{
+	const FT_Vector *pts[3] = { control1, control2, to };
+	add_segment( *(decompose_state*)user, 3, pts );
+	return 0;
+}
+
+bool decompose_outline(
+		const FT_Outline &outline,
+		glyph_outline &glyph )
+{
+	FT_Outline_Funcs funcs;
+	funcs.move_to = add_move_to;
+	funcs.line_to = add_line_to;
+	funcs.conic_to = add_conic_to;
+	funcs.cubic_to = add_cubic_to;
+	funcs.shift = 0;
+	funcs.delta = 0;
+	glyph.segments.clear();
+	glyph.even_odd = (outline.flags & FT_OUTLINE_EVEN_ODD_FILL) != 0;
+	glyph.reversed = (FT_Outline_Get_Orientation(
+			const_cast< FT_Outline* >( &outline ) ) == FT_ORIENTATION_POSTSCRIPT);
+	decompose_state s;
+	s.glyph = &glyph;
+	s.x = s.y = 0.0;
+	s.contour = -1;
+	return FT_Outline_Decompose( const_cast< FT_Outline* >( &outline ), &funcs, &s ) == 0;
+}
+
+void segment_point(
+		const outline_segment &seg,
+		double t,
+		double &x, double &y )
+{
+	double u = 1.0 - t;
+	switch( seg.order )
+	{
+	case 1:
+		x = u * seg.x[0] + t * seg.x[1];
+		y = u * seg.y[0] + t * seg.y[1];
+		break;
+	case 2:
+		x = u*u * seg.x[0] + 2.0*u*t * seg.x[1] + t*t * seg.x[2];
+		y = u*u * seg.y[0] + 2.0*u*t * seg.y[1] + t*t * seg.y[2];
+		break;
+	default:
+		x = u*u*u * seg.x[0] + 3.0*u*u*t * seg.x[1] + 3.0*u*t*t * seg.x[2] + t*t*t * seg.x[3];
+		y = u*u*u * seg.y[0] + 3.0*u*u*t * seg.y[1] + 3.0*u*t*t * seg.y[2] + t*t*t * seg.y[3];
+		break;
+	}
+}
+
+void segment_direction(
+		const outline_segment &seg,
+		double t,
+		double &dx, double &dy )
+{
+	double u = 1.0 - t;
+	switch( seg.order )
+	{
+	case 1:
+		dx = seg.x[1] - seg.x[0];
+		dy = seg.y[1] - seg.y[0];
+		break;
+	case 2:
+		dx = 2.0 * (u * (seg.x[1] - seg.x[0]) + t * (seg.x[2] - seg.x[1]));
+		dy = 2.0 * (u * (seg.y[1] - seg.y[0]) + t * (seg.y[2] - seg.y[1]));
+		break;
+	default:
+		dx = 3.0 * (u*u * (seg.x[1] - seg.x[0]) + 2.0*u*t * (seg.x[2] - seg.x[1]) + t*t * (seg.x[3] - seg.x[2]));
+		dy = 3.0 * (u*u * (seg.y[1] - seg.y[0]) + 2.0*u*t * (seg.y[2] - seg.y[1]) + t*t * (seg.y[3] - seg.y[2]));
+		break;
+	}
+	if( (dx == 0.0) && (dy == 0.0) )
+	{
+		//	a control point on top of an end point, use the chord
+		dx = seg.x[seg.order] - seg.x[0];
+		dy = seg.y[seg.order] - seg.y[0];
+	}
+}
+
+//	real roots of a*t^2 + b*t + c
+static int solve_quadratic( double a, double b, double c, double *t )
+{
+	if( fabs( a ) < 1e-12 )
+	{
+		if( fabs( b ) < 1e-12 )
+		{
+			return 0;
+		}
+		t[0] = -c / b;
+		return 1;
+	}
+	double disc = b*b - 4.0*a*c;
+	if( disc < 0.0 )
+	{
+		return 0;
+	}
+	disc = sqrt( disc );
+	t[0] = (-b + disc) / (2.0 * a);
+	t[1] = (-b - disc) / (2.0 * a);
+	return 2;
+}
+
+//	real roots of a*t^3 + b*t^2 + c*t + d
+static int solve_cubic( double a, double b, double c, double d, double *t )
+{
+	if( (a == 0.0) || (fabs( b / a ) > 1e6) )
+	{
+		//	(nearly) a quadratic
+		return solve_quadratic( b, c, d, t );
+	}
+	b /= a;
+	c /= a;
+	d /= a;
+	double q = (b*b - 3.0*c) / 9.0;
+	double r = (b*(2.0*b*b - 9.0*c) + 27.0*d) / 54.0;
+	double q3 = q*q*q;
+	b /= 3.0;
+	if( r*r < q3 )
+	{
+		double theta = acos( std::min( 1.0, std::max( -1.0, r / sqrt( q3 ) ) ) );
+		double m = -2.0 * sqrt( q );
+		const double third = 2.0943951023931953;	//	2 pi / 3
+		t[0] = m * cos( theta / 3.0 ) - b;
+		t[1] = m * cos( theta / 3.0 + third ) - b;
+		t[2] = m * cos( theta / 3.0 - third ) - b;
+		return 3;
+	}
+	double u = cbrt( fabs( r ) + sqrt( r*r - q3 ) );
+	if( r > 0.0 )
+	{
+		u = -u;
+	}
+	double v = (u == 0.0) ? 0.0 : q / u;
+	t[0] = (u + v) - b;
+	t[1] = -0.5 * (u + v) - b;
+	return (fabs( u - v ) < 1e-9 * fabs( u + v )) ? 2 : 1;
+}
+
+double segment_distance2(
+		const outline_segment &seg,
+		double px, double py,
+		double *t_best )
+{
+	//	always try the end points, then the interior critical points
+	double best_t = 0.0;
+	double dx = seg.x[0] - px;
+	double dy = seg.y[0] - py;
+	double best = dx*dx + dy*dy;
+	dx = seg.x[seg.order] - px;
+	dy = seg.y[seg.order] - py;
+	if( dx*dx + dy*dy < best )
+	{
+		best = dx*dx + dy*dy;
+		best_t = 1.0;
+	}
+	double roots[9];
+	int n = 0;
+	if( seg.order == 1 )
+	{
+		double ex = seg.x[1] - seg.x[0];
+		double ey = seg.y[1] - seg.y[0];
+		double len2 = ex*ex + ey*ey;
+		if( len2 > 0.0 )
+		{
+			roots[n++] = ((px - seg.x[0]) * ex + (py - seg.y[0]) * ey) / len2;
+		}
+	} else if( seg.order == 2 )
+	{
+		//	B(t) = P0 + 2tA + t^2 B, and (B(t) - p) . B'(t) = 0 is a cubic
+		double ax = seg.x[1] - seg.x[0];
+		double ay = seg.y[1] - seg.y[0];
+		double bx = seg.x[2] - 2.0 * seg.x[1] + seg.x[0];
+		double by = seg.y[2] - 2.0 * seg.y[1] + seg.y[0];
+		double mx = seg.x[0] - px;
+		double my = seg.y[0] - py;
+		n = solve_cubic(
+				bx*bx + by*by,
+				3.0 * (ax*bx + ay*by),
+				2.0 * (ax*ax + ay*ay) + mx*bx + my*by,
+				mx*ax + my*ay,
+				roots );
+	} else
+	{
+		//	a quintic, so Newton's method from evenly spaced starts
+		const int starts = 8;
+		for( int k = 0; k <= starts; ++k )
+		{
+			double t = (double)k / starts;
+			for( int it = 0; it < 4; ++it )
+			{
+				double x, y, d1x, d1y;
+				segment_point( seg, t, x, y );
+				segment_direction( seg, t, d1x, d1y );
+				double u = 1.0 - t;
+				double d2x = 6.0 * (u * (seg.x[2] - 2.0*seg.x[1] + seg.x[0]) + t * (seg.x[3] - 2.0*seg.x[2] + seg.x[1]));
+				double d2y = 6.0 * (u * (seg.y[2] - 2.0*seg.y[1] + seg.y[0]) + t * (seg.y[3] - 2.0*seg.y[2] + seg.y[1]));
+				x -= px;
+				y -= py;
+				double f1 = x*d1x + y*d1y;
+				double f2 = d1x*d1x + d1y*d1y + x*d2x + y*d2y;
+				if( f2 == 0.0 )
+				{
+					break;
+				}
+				t = std::min( 1.0, std::max( 0.0, t - f1 / f2 ) );
+			}
+			roots[n++] = t;
+		}
+	}
+	for( int k = 0; k < n; ++k )
+	{
+		if( (roots[k] > 0.0) && (roots[k] < 1.0) )
+		{
+			double x, y;
+			segment_point( seg, roots[k], x, y );
+			dx = x - px;
+			dy = y - py;
+			if( dx*dx + dy*dy < best )
+			{
+				best = dx*dx + dy*dy;
+				best_t = roots[k];
+			}
+		}
+	}
+	if( t_best != NULL )
+	{
+		*t_best = best_t;
+	}
+	return best;
+}
+
+//	Split every segment into straight pieces, close enough to the curve
+//	(tolerance in pixels) that only samples nearly on the outline could
+//	get the wrong sign, and there the distance is ~0 anyway.
+static void flatten_outline(
+		const glyph_outline &glyph,
+		double tolerance,
+		std::vector< double > &edges )
+{
+	edges.clear();
+	for( unsigned int k = 0; k < glyph.segments.size(); ++k )
+	{
+		const outline_segment &seg = glyph.segments[k];
+		int pieces = 1;
+		if( seg.order > 1 )
+		{
+			//	the flattening error bound of a Bezier with n pieces
+			double dev = 0.0;
+			for( int i = 0; i + 2 <= seg.order; ++i )
+			{
+				double ddx = seg.x[i] - 2.0 * seg.x[i+1] + seg.x[i+2];
+				double ddy = seg.y[i] - 2.0 * seg.y[i+1] + seg.y[i+2];
+				dev = std::max( dev, sqrt( ddx*ddx + ddy*ddy ) );
+			}
+			dev *= (seg.order == 2) ? 0.25 : 0.75;
+			pieces = std::min( 256, std::max( 1, (int)ceil( sqrt( dev / tolerance ) ) ) );
+		}
+		double x0 = seg.x[0];
+		double y0 = seg.y[0];
+		for( int i = 1; i <= pieces; ++i )
+		{
+			double x1, y1;
+			segment_point( seg, (double)i / pieces, x1, y1 );
+			edges.push_back( x0 );
+			edges.push_back( y0 );
+			edges.push_back( x1 );
+			edges.push_back( y1 );
+			x0 = x1;
+			y0 = y1;
+		}
+	}
+}
+
+void outline_inside(
+		const glyph_outline &glyph,
+		const std::vector< double > &xs,
+		const std::vector< double > &ys,
+		std::vector< unsigned char > &inside )
+{
+	int nx = xs.size();
+	inside.assign( xs.size() * ys.size(), 0 );
+	std::vector< double > edges;
+	flatten_outline( glyph, 1.0 / 32.0, edges );
+	//	where each edge crosses the scanline, and which way it goes
+	std::vector< std::pair< double, int > > crossings;
+	for( unsigned int j = 0; j < ys.size(); ++j )
+	{
+		double y = ys[j];
+		crossings.clear();
+		for( unsigned int e = 0; e < edges.size(); e += 4 )
+		{
+			double y0 = edges[e+1];
+			double y1 = edges[e+3];
+			//	half open, so a shared end point counts once
+			if( (y0 <= y) != (y1 <= y) )
+			{
+				double x = edges[e] + (y - y0) * (edges[e+2] - edges[e]) / (y1 - y0);
+				crossings.push_back( std::make_pair( x, (y1 > y0) ? 1 : -1 ) );
+			}
+		}
+		std::sort( crossings.begin(), crossings.end() );
+		unsigned int c = 0;
+		int winding = 0;
+		for( int i = 0; i < nx; ++i )
+		{
+			while( (c < crossings.size()) && (crossings[c].first < xs[i]) )
+			{
+				winding += crossings[c++].second;
+			}
+			inside[i + j * nx] = glyph.even_odd ? (winding & 1) : (winding != 0);
+		}
+	}
+}
+
+void build_segment_grid(
+		const glyph_outline &glyph,
+		const std::vector< double > &xs,
+		const std::vector< double > &ys,
+		int max_radius,
+		double cell,
+		segment_grid &grid )
+{
+	//	the grid covers the samples plus max_radius all round
+	grid.cell = std::max( cell, 1.0 );
+	grid.x_lo = std::min( xs.front(), xs.back() ) - max_radius;
+	grid.y_lo = std::min( ys.front(), ys.back() ) - max_radius;
+	double x_hi = std::max( xs.front(), xs.back() ) + max_radius;
+	double y_hi = std::max( ys.front(), ys.back() ) + max_radius;
+	grid.cw = (int)((x_hi - grid.x_lo) / grid.cell) + 1;
+	grid.ch = (int)((y_hi - grid.y_lo) / grid.cell) + 1;
+	//	the cells each segment's control box touches
+	int n_seg = glyph.segments.size();
+	std::vector< int > c0( n_seg ), c1( n_seg ), r0( n_seg ), r1( n_seg );
+	grid.box.resize( 4 * n_seg );
+	grid.start.assign( grid.cw * grid.ch + 1, 0 );
+	for( int k = 0; k < n_seg; ++k )
+	{
+		const outline_segment &seg = glyph.segments[k];
+		double *b = &grid.box[4 * k];
+		b[0] = *std::min_element( seg.x, seg.x + seg.order + 1 );
+		b[1] = *std::min_element( seg.y, seg.y + seg.order + 1 );
+		b[2] = *std::max_element( seg.x, seg.x + seg.order + 1 );
+		b[3] = *std::max_element( seg.y, seg.y + seg.order + 1 );
+		c0[k] = std::max( 0, (int)floor( (b[0] - grid.x_lo) / grid.cell ) );
+		c1[k] = std::min( grid.cw - 1, (int)floor( (b[2] - grid.x_lo) / grid.cell ) );
+		r0[k] = std::max( 0, (int)floor( (b[1] - grid.y_lo) / grid.cell ) );
+		r1[k] = std::min( grid.ch - 1, (int)floor( (b[3] - grid.y_lo) / grid.cell ) );
+		for( int r = r0[k]; r <= r1[k]; ++r )
+		{
+			for( int c = c0[k]; c <= c1[k]; ++c )
+			{
+				++grid.start[r * grid.cw + c + 1];
+			}
+		}
+	}
+	for( unsigned int c = 1; c < grid.start.size(); ++c )
+	{
+		grid.start[c] += grid.start[c-1];
+	}
+	grid.bucket.resize( grid.start.back() );
+	std::vector< int > fill( grid.start.begin(), grid.start.end() - 1 );
+	for( int k = 0; k < n_seg; ++k )
+	{
+		for( int r = r0[k]; r <= r1[k]; ++r )
+		{
+			for( int c = c0[k]; c <= c1[k]; ++c )
+			{
+				grid.bucket[fill[r * grid.cw + c]++] = k;
+			}
+		}
+	}
+	grid.mark.assign( n_seg, 0 );
+	grid.query = 0;
+}
+
+void find_near_segments(
+		segment_grid &grid,
+		double px, double py,
+		double radius,
+		std::vector< int > &near )
+{
+	near.clear();
+	if( ++grid.query == 0 )
+	{
+		//	the stamps wrapped around
+		grid.mark.assign( grid.mark.size(), 0 );
+		grid.query = 1;
+	}
+	int r0 = std::max( 0, (int)floor( (py - radius - grid.y_lo) / grid.cell ) );
+	int r1 = std::min( grid.ch - 1, (int)floor( (py + radius - grid.y_lo) / grid.cell ) );
+	int c0 = std::max( 0, (int)floor( (px - radius - grid.x_lo) / grid.cell ) );
+	int c1 = std::min( grid.cw - 1, (int)floor( (px + radius - grid.x_lo) / grid.cell ) );
+	for( int r = r0; r <= r1; ++r )
+	{
+		for( int c = c0; c <= c1; ++c )
+		{
+			int cell_index = r * grid.cw + c;
+			for( int b = grid.start[cell_index]; b < grid.start[cell_index+1]; ++b )
+			{
+				int k = grid.bucket[b];
+				if( grid.mark[k] != grid.query )
+				{
+					grid.mark[k] = grid.query;
+					near.push_back( k );
+				}
+			}
+		}
+	}
+}
+
+double segment_box_distance2(
+		const segment_grid &grid,
+		int k,
+		double px, double py )
+{
+	const double *b = &grid.box[4 * k];
+	double dx = std::max( 0.0, std::max( b[0] - px, px - b[2] ) );
+	double dy = std::max( 0.0, std::max( b[1] - py, py - b[3] ) );
+	return dx*dx + dy*dy;
+}
+
+void render_SDF_outline(
+		const glyph_outline &glyph,
+		const std::vector< double > &xs,
+		const std::vector< double > &ys,
+		int max_radius,
+		unsigned char *sdf )
+{
+	int nx = xs.size();
+	int ny = ys.size();
+	if( (nx < 1) || (ny < 1) )
+	{
+		return;
+	}
+	std::vector< unsigned char > inside;
+	outline_inside( glyph, xs, ys, inside );
+	segment_grid grid;
+	build_segment_grid( glyph, xs, ys, max_radius, max_radius, grid );
+
+	const double clamp_d2 = (double)max_radius * max_radius + 1.0;
+	std::vector< int > near;
+	for( int j = 0; j < ny; ++j )
+	{
+		for( int i = 0; i < nx; ++i )
+		{
+			double px = xs[i];
+			double py = ys[j];
+			find_near_segments( grid, px, py, max_radius, near );
+			double best = clamp_d2;
+			for( unsigned int n = 0; n < near.size(); ++n )
+			{
+				//	skip the segment if its control box is already too far
+				if( segment_box_distance2( grid, near[n], px, py ) < best )
+				{
+					best = std::min( best,
+							segment_distance2( glyph.segments[near[n]], px, py, NULL ) );
+				}
+			}
+			sdf[i + j * nx] = encode_SDF_distance( best, inside[i + j * nx] != 0, max_radius );
+		}
+	}
+}
+
+void refine_SDF_outline(
+		const glyph_outline &glyph,
+		const std::vector< double > &xs,
+		const std::vector< double > &ys,
+		int max_radius,
+		double slack,
+		unsigned char *sdf )
+{
+	int nx = xs.size();
+	int ny = ys.size();
+	if( (nx < 1) || (ny < 1) )
+	{
+		return;
+	}
+	std::vector< unsigned char > inside;
+	outline_inside( glyph, xs, ys, inside );
+	//	the searches are short, so finer cells than usual
+	segment_grid grid;
+	build_segment_grid( glyph, xs, ys, max_radius, max_radius / 4.0, grid );
+
+	const double clamp_d2 = (double)max_radius * max_radius + 1.0;
+	std::vector< int > near;
+	for( int j = 0; j < ny; ++j )
+	{
+		for( int i = 0; i < nx; ++i )
+		{
+			unsigned char &v = sdf[i + j * nx];
+			if( (v == 0) || (v == 255) )
+			{
+				//	the clamped bulk, nothing to refine
+				continue;
+			}
+			//	undo the encoding, the edge can't be much further than that
+			double coarse = fabs( v - 127.5 ) * max_radius / 127.5;
+			double radius = std::min( coarse + slack, (double)max_radius );
+			double px = xs[i];
+			double py = ys[j];
+			find_near_segments( grid, px, py, radius, near );
+			double best = clamp_d2;
+			for( unsigned int n = 0; n < near.size(); ++n )
+			{
+				if( segment_box_distance2( grid, near[n], px, py ) < best )
+				{
+					best = std::min( best,
+							segment_distance2( glyph.segments[near[n]], px, py, NULL ) );
+				}
+			}
+			v = encode_SDF_distance( best, inside[i + j * nx] != 0, max_radius );
+		}
+	}
+}
@@ -0,0 +1,139 @@
+#ifndef OUTLINESDF_H
+#define OUTLINESDF_H
+
+#include <vector>
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+#include FT_OUTLINE_H
+
+//	One piece of a glyph contour, in pixels with y up (FT_Outline space):
+//	order 1 is a line (points 0,1), 2 a quadratic and 3 a cubic Bezier.
+struct outline_segment
+{
+	int order;
+	double x[4], y[4];
+	//	which contour it belongs to
+	int contour;
+	//	the MSDF channels it contributes to (EDGE_WHITE until coloured)
+	int color;
+};
+
+enum
+{
+	EDGE_RED = 1,
+	EDGE_GREEN = 2,
+	EDGE_BLUE = 4,
+	EDGE_WHITE = 7
+};
+
+struct glyph_outline
+{
+	glyph_outline() : even_odd( false ), reversed( false ) {}
+	std::vector< outline_segment > segments;
+	//	FT_OUTLINE_EVEN_ODD_FILL, otherwise non-zero winding
+	bool even_odd;
+	//	filled on the left (PostScript), not the right (TrueType)
+	bool reversed;
+};
+
+//	split an FT_Outline into segments with FT_Outline_Decompose
+bool decompose_outline(
+		const FT_Outline &outline,
+		glyph_outline &glyph );
+
+//	squared distance from (px,py) to a segment, and the curve parameter
+//	of the nearest point (if t != NULL)
+double segment_distance2(
+		const outline_segment &seg,
+		double px, double py,
+		double *t );
+
+//	point on a segment at parameter t, and its direction there
+void segment_point(
+		const outline_segment &seg,
+		double t,
+		double &x, double &y );
+void segment_direction(
+		const outline_segment &seg,
+		double t,
+		double &dx, double &dy );
+
+//	Is each sample inside the glyph?  One scanline per row of samples
+//	(xs must be increasing), inside[i + j * xs.size()].
+void outline_inside(
+		const glyph_outline &glyph,
+		const std::vector< double > &xs,
+		const std::vector< double > &ys,
+		std::vector< unsigned char > &inside );
+
+//	Segments bucketed by the grid cells (covering the samples plus
+//	max_radius) that their control boxes touch, CSR layout
+struct segment_grid
+{
+	double x_lo, y_lo, cell;
+	int cw, ch;
+	std::vector< int > start;	//	cw * ch + 1 entries
+	std::vector< int > bucket;
+	//	x0, y0, x1, y1 of each segment's control box
+	std::vector< double > box;
+	//	so a query lists each segment once
+	std::vector< unsigned int > mark;
+	unsigned int query;
+};
+
+void build_segment_grid(
+		const glyph_outline &glyph,
+		const std::vector< double > &xs,
+		const std::vector< double > &ys,
+		int max_radius,
+		double cell,
+		segment_grid &grid );
+
+//	every segment in the cells within 'radius' of (px,py), a superset of
+//	the segments that are actually that close
+void find_near_segments(
+		segment_grid &grid,
+		double px, double py,
+		double radius,
+		std::vector< int > &near );
+
+//	a lower bound on segment_distance2 (from its control box)
+double segment_box_distance2(
+		const segment_grid &grid,
+		int k,
+		double px, double py );
+
+//	The exact signed distance from every sample (xs[i], ys[j]) to the
+//	outline, in the usual 0..255 encoding, without rasterizing anything.
+//	xs must be increasing.
+void render_SDF_outline(
+		const glyph_outline &glyph,
+		const std::vector< double > &xs,
+		const std::vector< double > &ys,
+		int max_radius,
+		unsigned char *sdf );
+
+//	Make a raster SDF of the same samples exact near the edge: every
+//	sample that isn't clamped only searches the segments within its
+//	coarse distance (plus 'slack' pixels for the raster's error), and
+//	takes its sign from the outline.  Clamped samples are left alone.
+void refine_SDF_outline(
+		const glyph_outline &glyph,
+		const std::vector< double > &xs,
+		const std::vector< double > &ys,
+		int max_radius,
+		double slack,
+		unsigned char *sdf );
+
+//	Multi-channel SDF (MultiChannelSDF.cpp): the segments are coloured so
+//	the median of the R, G, B pseudo-distances keeps sharp corners,
+//	3 bytes per sample
+void render_MSDF_outline(
+		const glyph_outline &glyph,
+		const std::vector< double > &xs,
+		const std::vector< double > &ys,
+		int max_radius,
+		unsigned char *rgb );
+
+#endif
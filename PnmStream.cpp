@@ -0,0 +1,116 @@
+#include <cctype>
+#include <vector>
+
+#include "PnmStream.hpp"
+
+//	the next header number, skipping white space and # comments
+static bool read_header_int( FILE *f, int &value )
+{
+	int c = fgetc( f );
+	for( ;; )
+	{
+		if( c == '#' )
+		{
+			while( (c != EOF) && (c != '\n') )
+			{
+				c = fgetc( f );
+			}
+		} else if( (c != EOF) && isspace( c ) )
+		{
+			c = fgetc( f );
+		} else
+		{
+			break;
+		}
+	}
+	if( (c == EOF) || !isdigit( c ) )
+	{
+		return false;
+	}
+	value = 0;
+	while( (c != EOF) && isdigit( c ) )
+	{
+		value = value * 10 + (c - '0');
+		c = fgetc( f );
+	}
+	//	exactly one white space character ends the header's last number
+	return (c != EOF) && isspace( c );
+}
+
+bool pnm_stream::open( const char *file_name )
+{
+	close();
+	f = fopen( file_name, "rb" );
+	if( f == NULL )
+	{
+		return false;
+	}
+	int maxval = 1;
+	char magic[2];
+	bool ok = (fread( magic, 1, 2, f ) == 2) && (magic[0] == 'P') &&
+			((magic[1] == '4') || (magic[1] == '5'));
+	if( ok )
+	{
+		bits = (magic[1] == '4');
+		ok = read_header_int( f, w ) && read_header_int( f, h ) &&
+				(bits || read_header_int( f, maxval )) &&
+				(w > 0) && (h > 0) && (maxval > 0) && (maxval < 256);
+	}
+	if( !ok )
+	{
+		close();
+		return false;
+	}
+	data_start = ftell( f );
+	row = 0;
+	return true;
+}
+
+void pnm_stream::close()
+{
+	if( f != NULL )
+	{
+		fclose( f );
+		f = NULL;
+	}
+}
+
+bool pnm_stream::rewind()
+{
+	row = 0;
+	return (f != NULL) && (fseek( f, data_start, SEEK_SET ) == 0);
+}
+
+bool pnm_stream::read_rows( int rows, unsigned char *out )
+{
+	if( (f == NULL) || (row + rows > h) )
+	{
+		return false;
+	}
+	if( !bits )
+	{
+		size_t n = (size_t)w * rows;
+		if( fread( out, 1, n, f ) != n )
+		{
+			return false;
+		}
+	} else
+	{
+		int pitch = (w + 7) >> 3;
+		std::vector< unsigned char > packed( pitch );
+		for( int j = 0; j < rows; ++j )
+		{
+			if( fread( &packed[0], 1, pitch, f ) != (size_t)pitch )
+			{
+				return false;
+			}
+			unsigned char *o = out + (size_t)j * w;
+			for( int i = 0; i < w; ++i )
+			{
+				o[i] = ((packed[i >> 3] >> (7 - (i & 7))) & 1) ? 0 : 255;
+			}
+		}
+	}
+	row += rows;
+	return true;
+}
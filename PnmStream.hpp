@@ -0,0 +1,29 @@
+#ifndef PNMSTREAM_H
+#define PNMSTREAM_H
+
+#include <cstdio>
+
+//	Reads binary PGM (P5, 8 bit) and PBM (P4) images a few rows at a time,
+//	so a huge mask never has to be in memory all at once.  PBM pixels
+//	come out as 0 (black, bit set) or 255 (white).
+struct pnm_stream
+{
+	pnm_stream() : f( NULL ), w( 0 ), h( 0 ), bits( false ), row( 0 ), data_start( 0 ) {}
+	~pnm_stream() { close(); }
+
+	//	false if this is not a P4 / P5 file (or not 8 bit)
+	bool open( const char *file_name );
+	void close();
+	//	back to the first row
+	bool rewind();
+	//	read the next 'rows' rows (w bytes each) into out
+	bool read_rows( int rows, unsigned char *out );
+
+	FILE *f;
+	int w, h;
+	bool bits;
+	int row;
+	long data_start;
+};
+
+#endif
@@ -0,0 +1,417 @@
+//	SIMD versions of the radial ring search.  They visit the same rings
+//	in the same order as get_SDF_radial_scalar, but instead of testing
+//	every pixel on a ring side they only look for the pixel nearest to
+//	the centre of that side, which is all the minimum ever depends on.
+//	The result is bit-identical to the scalar kernel.
+
+#include <cstring>
+#include <mutex>
+
+#include "DistanceField.hpp"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+
+#include <immintrin.h>
+
+//	Scalar helper, used for the parts of a row or column that are too
+//	close to the end of the buffer for a full vector load.  Returns the
+//	distance from c to the nearest pixel != v in [lo,hi] (both sides), or
+//	-1 if there is none.
+static inline int nearest_scalar(
+		const unsigned char *p,
+		int stride,
+		int c, int lo, int hi,
+		unsigned char v )
+{
+	for( int d = 0; (c - d >= lo) || (c + d <= hi); ++d )
+	{
+		if( (c - d >= lo) && (p[(c - d) * stride] != v) )
+		{
+			return d;
+		}
+		if( (c + d <= hi) && (p[(c + d) * stride] != v) )
+		{
+			return d;
+		}
+	}
+	return -1;
+}
+
+//	keep the smaller non-negative distance
+static inline int closer( int a, int b )
+{
+	if( a < 0 ) return b;
+	if( b < 0 ) return a;
+	return (a < b) ? a : b;
+}
+
+#pragma GCC push_options
+#pragma GCC target("avx2")
+
+//	nearest pixel != v to column x, in row[lo..hi] of a row w wide
+static int nearest_in_row_avx2(
+		const unsigned char *row,
+		int w,
+		int x, int lo, int hi,
+		unsigned char v )
+{
+	const __m256i vv = _mm256_set1_epi8( (char)v );
+	int best = -1;
+	//	to the right, including x
+	for( int p = x; p <= hi; p += 32 )
+	{
+		if( p + 32 > w )
+		{
+			int d = nearest_scalar( row, 1, p, p, hi, v );
+			if( d >= 0 ) { best = p + d - x; }
+			break;
+		}
+		__m256i a = _mm256_loadu_si256( (const __m256i*)(row + p) );
+		unsigned int m = ~(unsigned int)_mm256_movemask_epi8( _mm256_cmpeq_epi8( a, vv ) );
+		int n = hi - p + 1;
+		if( n < 32 ) { m &= (1u << n) - 1; }
+		if( m )
+		{
+			best = p + __builtin_ctz( m ) - x;
+			break;
+		}
+	}
+	//	to the left, only while it could still be closer
+	for( int p = x - 1; p >= lo; p -= 32 )
+	{
+		if( (best >= 0) && (x - p >= best) )
+		{
+			break;
+		}
+		int c = p - 31;
+		if( c < 0 )
+		{
+			int d = nearest_scalar( row, 1, p, lo, p, v );
+			if( d >= 0 ) { best = closer( best, x - p + d ); }
+			break;
+		}
+		__m256i a = _mm256_loadu_si256( (const __m256i*)(row + c) );
+		unsigned int m = ~(unsigned int)_mm256_movemask_epi8( _mm256_cmpeq_epi8( a, vv ) );
+		int n = lo - c;
+		if( n > 0 ) { m &= ~((1u << n) - 1); }
+		if( m )
+		{
+			best = closer( best, x - (c + 31 - __builtin_clz( m )) );
+			break;
+		}
+	}
+	return best;
+}
+
+//	nearest pixel != v to row y, in column col, rows [lo..hi]
+static int nearest_in_col_avx2(
+		const unsigned char *img,
+		int w, int h,
+		int col, int y, int lo, int hi,
+		unsigned char v )
+{
+	//	the gathers read 4 bytes, keep them inside the buffer
+	if( (hi == h - 1) && (col + 4 > w) )
+	{
+		return nearest_scalar( img + col, w, y, lo, hi, v );
+	}
+	const __m256i vv = _mm256_set1_epi32( v );
+	const __m256i low_byte = _mm256_set1_epi32( 0xFF );
+	const __m256i lane = _mm256_setr_epi32( 0, 1, 2, 3, 4, 5, 6, 7 );
+	const __m256i down = _mm256_mullo_epi32( lane, _mm256_set1_epi32( w ) );
+	const __m256i up = _mm256_mullo_epi32( lane, _mm256_set1_epi32( -w ) );
+	int best = -1;
+	//	downwards, including y
+	for( int p = y; p <= hi; p += 8 )
+	{
+		int n = hi - p + 1;
+		if( n > 8 ) { n = 8; }
+		__m256i valid = _mm256_cmpgt_epi32( _mm256_set1_epi32( n ), lane );
+		__m256i g = _mm256_mask_i32gather_epi32(
+				_mm256_setzero_si256(), (const int*)(img + p * w + col),
+				down, valid, 1 );
+		__m256i eq = _mm256_cmpeq_epi32( _mm256_and_si256( g, low_byte ), vv );
+		unsigned int m = ~_mm256_movemask_ps( _mm256_castsi256_ps( eq ) ) & ((1u << n) - 1);
+		if( m )
+		{
+			best = p + __builtin_ctz( m ) - y;
+			break;
+		}
+	}
+	//	upwards, only while it could still be closer
+	for( int p = y - 1; p >= lo; p -= 8 )
+	{
+		if( (best >= 0) && (y - p >= best) )
+		{
+			break;
+		}
+		int n = p - lo + 1;
+		if( n > 8 ) { n = 8; }
+		__m256i valid = _mm256_cmpgt_epi32( _mm256_set1_epi32( n ), lane );
+		__m256i g = _mm256_mask_i32gather_epi32(
+				_mm256_setzero_si256(), (const int*)(img + p * w + col),
+				up, valid, 1 );
+		__m256i eq = _mm256_cmpeq_epi32( _mm256_and_si256( g, low_byte ), vv );
+		unsigned int m = ~_mm256_movemask_ps( _mm256_castsi256_ps( eq ) ) & ((1u << n) - 1);
+		if( m )
+		{
+			best = closer( best, y - p + __builtin_ctz( m ) );
+			break;
+		}
+	}
+	return best;
+}
+
+unsigned char get_SDF_radial_avx2(
+		const unsigned char *fontmap,
+		int w, int h,
+		int x, int y,
+		int max_radius )
+{
+	float d2 = max_radius*max_radius+1.0;
+	unsigned char v = fontmap[x+y*w];
+	for( int radius = 1; (radius <= max_radius) && (radius*radius < d2); ++radius )
+	{
+		int line, lo, hi, d;
+		//	north and south
+		lo = x - radius;
+		hi = x + radius;
+		if( lo < 0 ) { lo = 0; }
+		if( hi >= w ) { hi = w-1; }
+		for( line = y - radius; line <= y + radius; line += 2*radius )
+		{
+			if( (line >= 0) && (line < h) )
+			{
+				d = nearest_in_row_avx2( fontmap + line * w, w, x, lo, hi, v );
+				if( d >= 0 )
+				{
+					float nd2 = (float)(d*d + radius*radius);
+					if( nd2 < d2 ) { d2 = nd2; }
+				}
+			}
+		}
+		//	west and east
+		lo = y - radius + 1;
+		hi = y + radius - 1;
+		if( lo < 0 ) { lo = 0; }
+		if( hi >= h ) { hi = h-1; }
+		for( line = x - radius; line <= x + radius; line += 2*radius )
+		{
+			if( (line >= 0) && (line < w) )
+			{
+				d = nearest_in_col_avx2( fontmap, w, h, line, y, lo, hi, v );
+				if( d >= 0 )
+				{
+					float nd2 = (float)(d*d + radius*radius);
+					if( nd2 < d2 ) { d2 = nd2; }
+				}
+			}
+		}
+	}
+	return encode_SDF_distance( d2, v != 0, max_radius );
+}
+
+#pragma GCC pop_options
+
+//	SSE2 is always there on x86-64: 16 wide rows, scalar columns
+static int nearest_in_row_sse2(
+		const unsigned char *row,
+		int w,
+		int x, int lo, int hi,
+		unsigned char v )
+{
+	const __m128i vv = _mm_set1_epi8( (char)v );
+	int best = -1;
+	for( int p = x; p <= hi; p += 16 )
+	{
+		if( p + 16 > w )
+		{
+			int d = nearest_scalar( row, 1, p, p, hi, v );
+			if( d >= 0 ) { best = p + d - x; }
+			break;
+		}
+		__m128i a = _mm_loadu_si128( (const __m128i*)(row + p) );
+		unsigned int m = ~(unsigned int)_mm_movemask_epi8( _mm_cmpeq_epi8( a, vv ) ) & 0xFFFF;
+		int n = hi - p + 1;
+		if( n < 16 ) { m &= (1u << n) - 1; }
+		if( m )
+		{
+			best = p + __builtin_ctz( m ) - x;
+			break;
+		}
+	}
+	for( int p = x - 1; p >= lo; p -= 16 )
+	{
+		if( (best >= 0) && (x - p >= best) )
+		{
+			break;
+		}
+		int c = p - 15;
+		if( c < 0 )
+		{
+			int d = nearest_scalar( row, 1, p, lo, p, v );
+			if( d >= 0 ) { best = closer( best, x - p + d ); }
+			break;
+		}
+		__m128i a = _mm_loadu_si128( (const __m128i*)(row + c) );
+		unsigned int m = ~(unsigned int)_mm_movemask_epi8( _mm_cmpeq_epi8( a, vv ) ) & 0xFFFF;
+		int n = lo - c;
+		if( n > 0 ) { m &= ~((1u << n) - 1); }
+		if( m )
+		{
+			best = closer( best, x - (c + 31 - __builtin_clz( m )) );
+			break;
+		}
+	}
+	return best;
+}
+
+unsigned char get_SDF_radial_sse2(
+		const unsigned char *fontmap,
+		int w, int h,
+		int x, int y,
+		int max_radius )
+{
+	float d2 = max_radius*max_radius+1.0;
+	unsigned char v = fontmap[x+y*w];
+	for( int radius = 1; (radius <= max_radius) && (radius*radius < d2); ++radius )
+	{
+		int line, lo, hi, d;
+		//	north and south
+		lo = x - radius;
+		hi = x + radius;
+		if( lo < 0 ) { lo = 0; }
+		if( hi >= w ) { hi = w-1; }
+		for( line = y - radius; line <= y + radius; line += 2*radius )
+		{
+			if( (line >= 0) && (line < h) )
+			{
+				d = nearest_in_row_sse2( fontmap + line * w, w, x, lo, hi, v );
+				if( d >= 0 )
+				{
+					float nd2 = (float)(d*d + radius*radius);
+					if( nd2 < d2 ) { d2 = nd2; }
+				}
+			}
+		}
+		//	west and east
+		lo = y - radius + 1;
+		hi = y + radius - 1;
+		if( lo < 0 ) { lo = 0; }
+		if( hi >= h ) { hi = h-1; }
+		for( line = x - radius; line <= x + radius; line += 2*radius )
+		{
+			if( (line >= 0) && (line < w) && (lo <= hi) )
+			{
+				d = nearest_scalar( fontmap + line, w, y, lo, hi, v );
+				if( d >= 0 )
+				{
+					float nd2 = (float)(d*d + radius*radius);
+					if( nd2 < d2 ) { d2 = nd2; }
+				}
+			}
+		}
+	}
+	return encode_SDF_distance( d2, v != 0, max_radius );
+}
+
+static bool cpu_has_avx2()
+{
+	__builtin_cpu_init();
+	return __builtin_cpu_supports( "avx2" );
+}
+
+#else
+
+//	no SIMD on this platform, everything is scalar
+static bool cpu_has_avx2()
+{
+	return false;
+}
+
+unsigned char get_SDF_radial_avx2(
+		const unsigned char *fontmap,
+		int w, int h,
+		int x, int y,
+		int max_radius )
+{
+	return get_SDF_radial_scalar( fontmap, w, h, x, y, max_radius );
+}
+
+unsigned char get_SDF_radial_sse2(
+		const unsigned char *fontmap,
+		int w, int h,
+		int x, int y,
+		int max_radius )
+{
+	return get_SDF_radial_scalar( fontmap, w, h, x, y, max_radius );
+}
+
+#endif
+
+//	picked on the first call (once, even if several threads get there
+//	together), then only set_radial_isa changes it
+static radial_kernel radial_dispatch = NULL;
+static const char *radial_dispatch_name = NULL;
+static std::once_flag radial_dispatch_once;
+
+static void pick_radial_isa()
+{
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+	if( cpu_has_avx2() )
+	{
+		radial_dispatch = get_SDF_radial_avx2;
+		radial_dispatch_name = "avx2";
+		return;
+	}
+#if defined(__SSE2__)
+	radial_dispatch = get_SDF_radial_sse2;
+	radial_dispatch_name = "sse2";
+	return;
+#endif
+#endif
+	radial_dispatch = get_SDF_radial_scalar;
+	radial_dispatch_name = "scalar";
+}
+
+bool set_radial_isa( const char *name )
+{
+	//	(after the automatic pick, so it can't be overwritten later)
+	std::call_once( radial_dispatch_once, pick_radial_isa );
+	if( strcmp( name, "auto" ) == 0 )
+	{
+		pick_radial_isa();
+	} else if( strcmp( name, "scalar" ) == 0 )
+	{
+		radial_dispatch = get_SDF_radial_scalar;
+		radial_dispatch_name = "scalar";
+	} else if( strcmp( name, "sse2" ) == 0 )
+	{
+		radial_dispatch = get_SDF_radial_sse2;
+		radial_dispatch_name = "sse2";
+	} else if( (strcmp( name, "avx2" ) == 0) && cpu_has_avx2() )
+	{
+		radial_dispatch = get_SDF_radial_avx2;
+		radial_dispatch_name = "avx2";
+	} else
+	{
+		return false;
+	}
+	return true;
+}
+
+const char* radial_isa_name()
+{
+	std::call_once( radial_dispatch_once, pick_radial_isa );
+	return radial_dispatch_name;
+}
+
+unsigned char get_SDF_radial(
+		const unsigned char *fontmap,
+		int w, int h,
+		int x, int y,
+		int max_radius )
+{
+	std::call_once( radial_dispatch_once, pick_radial_isa );
+	return radial_dispatch( fontmap, w, h, x, y, max_radius );
+}
@@ -0,0 +1,216 @@
+//	Spiral version of the radial search.  Instead of walking square rings
+//	and refining d2, visit the offsets of a precomputed table sorted by
+//	Euclidean distance, so the very first opposite pixel is the answer.
+//	The bitmap is copied into a buffer with a max_radius border of a
+//	value that is never "opposite" (the input is strictly 0 / 255), so
+//	the inner loop needs no bounds checks at all.
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <mutex>
+#include <vector>
+
+#include "DistanceField.hpp"
+
+static bool spiral_less( const spiral_offset &a, const spiral_offset &b )
+{
+	if( a.d2 != b.d2 ) return a.d2 < b.d2;
+	if( a.dy != b.dy ) return a.dy < b.dy;
+	return a.dx < b.dx;
+}
+
+const std::vector< spiral_offset > &get_spiral_table( int max_radius )
+{
+	static std::map< int, std::vector< spiral_offset > > tables;
+	static std::mutex tables_mutex;
+	std::lock_guard< std::mutex > lock( tables_mutex );
+	std::vector< spiral_offset > &table = tables[max_radius];
+	if( table.empty() )
+	{
+		//	anything further than max_radius is clamped anyway
+		int r2 = max_radius * max_radius;
+		for( int dy = -max_radius; dy <= max_radius; ++dy )
+		{
+			for( int dx = -max_radius; dx <= max_radius; ++dx )
+			{
+				int d2 = dx*dx + dy*dy;
+				if( (d2 > 0) && (d2 <= r2) )
+				{
+					spiral_offset o = { dx, dy, d2 };
+					table.push_back( o );
+				}
+			}
+		}
+		std::sort( table.begin(), table.end(), spiral_less );
+	}
+	return table;
+}
+
+void pad_bitmap(
+		const unsigned char *img,
+		int w, int h,
+		int border,
+		unsigned char fill,
+		std::vector< unsigned char > &padded )
+{
+	int pw = w + 2 * border;
+	padded.assign( pw * (h + 2 * border), fill );
+	for( int y = 0; y < h; ++y )
+	{
+		std::copy( img + y * w, img + (y + 1) * w,
+				padded.begin() + (y + border) * pw + border );
+	}
+}
+
+void render_SDF_grid_spiral(
+		const unsigned char *img,
+		int w, int h,
+		const std::vector< int > &xs,
+		const std::vector< int > &ys,
+		int max_radius,
+		unsigned char *sdf )
+{
+	const std::vector< spiral_offset > &table = get_spiral_table( max_radius );
+	//	1 is neither 0 nor 255, so the border never matches
+	std::vector< unsigned char > padded;
+	pad_bitmap( img, w, h, max_radius, 1, padded );
+	int pitch = w + 2 * max_radius;
+	std::vector< int > offset( table.size() );
+	for( unsigned int k = 0; k < table.size(); ++k )
+	{
+		offset[k] = table[k].dx + table[k].dy * pitch;
+	}
+	std::vector< unsigned char > mask;
+	build_edge_mask( img, w, h, max_radius, mask );
+	const int clamp_d2 = max_radius * max_radius + 1;
+	const int n = table.size();
+	int nx = xs.size();
+	for( unsigned int j = 0; j < ys.size(); ++j )
+	{
+		for( int i = 0; i < nx; ++i )
+		{
+			int x = xs[i];
+			int y = ys[j];
+			unsigned char v = img[x + y * w];
+			if( !mask[x + y * w] )
+			{
+				sdf[i + j * nx] = v ? 255 : 0;
+				continue;
+			}
+			const unsigned char ov = 255 - v;
+			const unsigned char *p = &padded[(y + max_radius) * pitch + x + max_radius];
+			int d2 = clamp_d2;
+			for( int k = 0; k < n; ++k )
+			{
+				if( p[offset[k]] == ov )
+				{
+					d2 = table[k].d2;
+					break;
+				}
+			}
+			sdf[i + j * nx] = encode_SDF_distance( d2, v != 0, max_radius );
+		}
+	}
+}
+
+//	Coherent version of the spiral search.  Within a row, neighbouring
+//	samples are 'step' pixels apart, and the distance to a fixed set of
+//	pixels is 1-Lipschitz, so if the previous sample (with the same
+//	value) was at distance d, this one is at least d - step away and at
+//	most as far as the previous nearest pixel.  The table scan can then
+//	start at that lower bound and stop at the upper one.
+void render_SDF_grid_coherent(
+		const unsigned char *img,
+		int w, int h,
+		const std::vector< int > &xs,
+		const std::vector< int > &ys,
+		int max_radius,
+		unsigned char *sdf )
+{
+	const std::vector< spiral_offset > &table = get_spiral_table( max_radius );
+	std::vector< unsigned char > padded;
+	pad_bitmap( img, w, h, max_radius, 1, padded );
+	int pitch = w + 2 * max_radius;
+	std::vector< int > offset( table.size() );
+	for( unsigned int k = 0; k < table.size(); ++k )
+	{
+		offset[k] = table[k].dx + table[k].dy * pitch;
+	}
+	std::vector< unsigned char > mask;
+	build_edge_mask( img, w, h, max_radius, mask );
+	const int clamp_d2 = max_radius * max_radius + 1;
+	const int n = table.size();
+	int nx = xs.size();
+	for( unsigned int j = 0; j < ys.size(); ++j )
+	{
+		int y = ys[j];
+		//	what the previous sample in this row found
+		bool have_prev = false;
+		unsigned char prev_v = 0;
+		int prev_x = 0, prev_d2 = 0;
+		bool prev_hit = false;
+		int hit_x = 0, hit_y = 0;
+		for( int i = 0; i < nx; ++i )
+		{
+			int x = xs[i];
+			unsigned char v = img[x + y * w];
+			if( !mask[x + y * w] )
+			{
+				sdf[i + j * nx] = v ? 255 : 0;
+				have_prev = true;
+				prev_v = v;
+				prev_x = x;
+				prev_d2 = clamp_d2;
+				prev_hit = false;
+				continue;
+			}
+			int start = 0;
+			int stop_d2 = clamp_d2;
+			if( have_prev && (prev_v == v) )
+			{
+				float lb = sqrtf( (float)prev_d2 ) - (x - prev_x);
+				if( lb > 1.0f )
+				{
+					//	one less, in case the float rounded up
+					spiral_offset key = { 0, 0, (int)(lb * lb) - 1 };
+					start = std::lower_bound( table.begin(), table.end(), key,
+							spiral_less ) - table.begin();
+				}
+				if( prev_hit )
+				{
+					int dx = hit_x - x;
+					int dy = hit_y - y;
+					if( dx*dx + dy*dy < stop_d2 )
+					{
+						stop_d2 = dx*dx + dy*dy;
+					}
+				}
+			}
+			const unsigned char ov = 255 - v;
+			const unsigned char *p = &padded[(y + max_radius) * pitch + x + max_radius];
+			int d2 = stop_d2;
+			bool hit = prev_hit && (prev_v == v) && (stop_d2 < clamp_d2);
+			int hx = hit_x, hy = hit_y;
+			for( int k = start; (k < n) && (table[k].d2 < stop_d2); ++k )
+			{
+				if( p[offset[k]] == ov )
+				{
+					d2 = table[k].d2;
+					hit = true;
+					hx = x + table[k].dx;
+					hy = y + table[k].dy;
+					break;
+				}
+			}
+			sdf[i + j * nx] = encode_SDF_distance( d2, v != 0, max_radius );
+			have_prev = true;
+			prev_v = v;
+			prev_x = x;
+			prev_d2 = d2;
+			prev_hit = hit;
+			hit_x = hx;
+			hit_y = hy;
+		}
+	}
+}
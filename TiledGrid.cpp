@@ -0,0 +1,122 @@
+//	Tiled, multi-threaded render_SDF_grid for large bitmaps.  The sample
+//	grid is cut into blocks, and each block only needs the source pixels
+//	within max_radius of its samples: that window is copied into a small
+//	contiguous buffer (so a worker's whole working set stays in L2) and
+//	handed to the normal backend.  Nothing further than max_radius can
+//	change a sample, so the result is identical to the untiled one, and
+//	every block writes its own part of sdf, so it doesn't depend on the
+//	thread count or order.
+//	edt sweeps the whole image once whatever the sample count, and its
+//	passes split cleanly into bands of columns / rows, so it is threaded
+//	that way instead.  8ssedt and aaedt sweep too, but every pixel depends
+//	on the ones before it in both directions, so they stay tiled, with
+//	windows that grow with max_radius so that the border they repeat
+//	stays a small share of the work.
+
+#include <algorithm>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "DistanceField.hpp"
+#include "WorkStealing.hpp"
+
+//	source window side we aim for, 512^2 bytes sits well inside L2
+static const int tile_window = 512;
+
+//	8ssedt and aaedt repeat their sweeps over each window's border, so
+//	their windows are at least 8 max_radius wide
+static bool sweeping_backend( sdf_backend backend )
+{
+	return (backend == SDF_BACKEND_8SSEDT) || (backend == SDF_BACKEND_AAEDT);
+}
+
+static int window_side( sdf_backend backend, int max_radius )
+{
+	if( sweeping_backend( backend ) )
+	{
+		return std::max( tile_window, 8 * max_radius );
+	}
+	return tile_window;
+}
+
+void render_SDF_grid_tiled(
+		sdf_backend backend,
+		const unsigned char *img,
+		int w, int h,
+		const std::vector< int > &xs,
+		const std::vector< int > &ys,
+		int max_radius,
+		int jobs,
+		unsigned char *sdf )
+{
+	int nx = xs.size();
+	int ny = ys.size();
+	if( (nx < 1) || (ny < 1) )
+	{
+		return;
+	}
+	if( jobs < 1 )
+	{
+		jobs = std::thread::hardware_concurrency();
+	}
+	if( backend == SDF_BACKEND_EDT )
+	{
+		render_SDF_grid_EDT( img, w, h, xs, ys, max_radius, jobs, sdf );
+		return;
+	}
+	int window = window_side( backend, max_radius );
+	if( sweeping_backend( backend ) && (jobs == 1) && (window > tile_window) )
+	{
+		//	too big for L2 anyway, and no other thread to share the borders
+		render_SDF_grid( backend, img, w, h, xs, ys, max_radius, sdf );
+		return;
+	}
+	//	samples per block side, from the average sample spacing
+	int spacing = std::max( 1, std::max(
+			(xs.back() - xs.front()) / std::max( 1, nx - 1 ),
+			(ys.back() - ys.front()) / std::max( 1, ny - 1 ) ) );
+	int tile = std::max( 4, (window - 2 * max_radius) / spacing );
+	int tiles_x = (nx + tile - 1) / tile;
+	int tiles_y = (ny + tile - 1) / tile;
+	//	all blocks cost about the same
+	std::vector< long long > cost( tiles_x * tiles_y, 1 );
+	std::vector< thread_load > load;
+	run_work_stealing( cost, jobs,
+			[&]( int t, int )
+			{
+				int i0 = (t % tiles_x) * tile;
+				int j0 = (t / tiles_x) * tile;
+				int i1 = std::min( i0 + tile, nx );
+				int j1 = std::min( j0 + tile, ny );
+				int x0 = std::max( xs[i0] - max_radius, 0 );
+				int x1 = std::min( xs[i1-1] + max_radius, w - 1 );
+				int y0 = std::max( ys[j0] - max_radius, 0 );
+				int y1 = std::min( ys[j1-1] + max_radius, h - 1 );
+				int ww = x1 - x0 + 1;
+				int wh = y1 - y0 + 1;
+				std::vector< unsigned char > window( ww * wh );
+				for( int y = 0; y < wh; ++y )
+				{
+					memcpy( &window[y * ww], img + (y + y0) * w + x0, ww );
+				}
+				std::vector< int > wxs( xs.begin() + i0, xs.begin() + i1 );
+				std::vector< int > wys( ys.begin() + j0, ys.begin() + j1 );
+				for( unsigned int i = 0; i < wxs.size(); ++i )
+				{
+					wxs[i] -= x0;
+				}
+				for( unsigned int j = 0; j < wys.size(); ++j )
+				{
+					wys[j] -= y0;
+				}
+				std::vector< unsigned char > block( wxs.size() * wys.size() );
+				render_SDF_grid( backend, &window[0], ww, wh,
+						wxs, wys, max_radius, &block[0] );
+				for( int j = j0; j < j1; ++j )
+				{
+					memcpy( sdf + j * nx + i0, &block[(j - j0) * (i1 - i0)], i1 - i0 );
+				}
+			},
+			load );
+}
@@ -0,0 +1,162 @@
+//	A small work stealing scheduler for a fixed set of tasks.  No task is
+//	ever added once the run starts, so each queue is just a [head,tail)
+//	range over its (largest first) task list, packed into one atomic word:
+//	the owner takes from the head, thieves take from the tail, and both
+//	are a single compare-and-swap.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+#include "WorkStealing.hpp"
+
+struct task_queue
+{
+	task_queue() : range( 0 ) {}
+	std::vector< int > ids;
+	//	head in the low 32 bits, tail in the high 32 bits
+	std::atomic< unsigned long long > range;
+	//	keep neighbouring queues off each other's cache line
+	char pad[64];
+};
+
+static inline unsigned long long pack_range( unsigned int head, unsigned int tail )
+{
+	return ((unsigned long long)tail << 32) | head;
+}
+
+static int pop_front( task_queue &q )
+{
+	unsigned long long r = q.range.load();
+	for( ;; )
+	{
+		unsigned int head = (unsigned int)r;
+		unsigned int tail = (unsigned int)(r >> 32);
+		if( head >= tail )
+		{
+			return -1;
+		}
+		if( q.range.compare_exchange_weak( r, pack_range( head + 1, tail ) ) )
+		{
+			return q.ids[head];
+		}
+	}
+}
+
+static int steal_back( task_queue &q )
+{
+	unsigned long long r = q.range.load();
+	for( ;; )
+	{
+		unsigned int head = (unsigned int)r;
+		unsigned int tail = (unsigned int)(r >> 32);
+		if( head >= tail )
+		{
+			return -1;
+		}
+		if( q.range.compare_exchange_weak( r, pack_range( head, tail - 1 ) ) )
+		{
+			return q.ids[tail - 1];
+		}
+	}
+}
+
+void run_work_stealing(
+		const std::vector< long long > &cost,
+		int threads,
+		const std::function< void( int, int ) > &task,
+		std::vector< thread_load > &load )
+{
+	int n = cost.size();
+	threads = std::max( 1, std::min( threads, n ) );
+	load.assign( threads, thread_load() );
+	if( n < 1 )
+	{
+		return;
+	}
+	//	largest first, dealt out back and forth (0,1,2,2,1,0,0,1,...) so
+	//	every queue starts with about the same total cost
+	std::vector< int > order( n );
+	for( int i = 0; i < n; ++i )
+	{
+		order[i] = i;
+	}
+	std::stable_sort( order.begin(), order.end(),
+			[&]( int a, int b ) { return cost[a] > cost[b]; } );
+	std::vector< task_queue > queues( threads );
+	for( int r = 0; r < n; ++r )
+	{
+		int pos = r % threads;
+		int q = ((r / threads) & 1) ? (threads - 1 - pos) : pos;
+		queues[q].ids.push_back( order[r] );
+	}
+	for( int k = 0; k < threads; ++k )
+	{
+		queues[k].range.store( pack_range( 0, queues[k].ids.size() ) );
+	}
+	auto worker = [&]( int k )
+	{
+		thread_load &me = load[k];
+		for( ;; )
+		{
+			int t = pop_front( queues[k] );
+			if( t < 0 )
+			{
+				//	out of work, try everyone else in turn
+				for( int v = 1; (v < threads) && (t < 0); ++v )
+				{
+					t = steal_back( queues[(k + v) % threads] );
+				}
+				if( t < 0 )
+				{
+					break;
+				}
+				++me.steals;
+			}
+			std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+			task( t, k );
+			std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+			me.seconds += std::chrono::duration< double >( t1 - t0 ).count();
+			me.cost += cost[t];
+			++me.tasks;
+		}
+	};
+	std::vector< std::thread > pool;
+	for( int k = 1; k < threads; ++k )
+	{
+		pool.push_back( std::thread( worker, k ) );
+	}
+	worker( 0 );
+	for( unsigned int k = 0; k < pool.size(); ++k )
+	{
+		pool[k].join();
+	}
+}
+
+void print_load_balance( const std::vector< thread_load > &load )
+{
+	if( load.size() < 2 )
+	{
+		return;
+	}
+	double sum = 0.0, busiest = 0.0;
+	int steals = 0;
+	for( unsigned int k = 0; k < load.size(); ++k )
+	{
+		sum += load[k].seconds;
+		busiest = std::max( busiest, load[k].seconds );
+		steals += load[k].steals;
+	}
+	double mean = sum / load.size();
+	printf( "Load balance over %i threads: busiest %1.3f s, mean %1.3f s, "
+			"imbalance %1.3f, %i steals\n",
+			(int)load.size(), busiest, mean,
+			(mean > 0.0) ? busiest / mean : 1.0, steals );
+	for( unsigned int k = 0; k < load.size(); ++k )
+	{
+		printf( "  thread %2i: %6i tasks %5i steals %12lli cost %9.3f s\n",
+				k, load[k].tasks, load[k].steals, load[k].cost, load[k].seconds );
+	}
+}
@@ -0,0 +1,33 @@
+#ifndef WORKSTEALING_H
+#define WORKSTEALING_H
+
+#include <functional>
+#include <vector>
+
+//	what one thread did during run_work_stealing
+struct thread_load
+{
+	thread_load() : tasks( 0 ), steals( 0 ), cost( 0 ), seconds( 0.0 ) {}
+	int tasks;
+	int steals;
+	//	sum of the predicted costs of the tasks it ran
+	long long cost;
+	//	time spent inside the task function
+	double seconds;
+};
+
+//	Run task( i, thread ) for every i in [0, cost.size()) on 'threads'
+//	threads (the calling thread is thread 0).  The tasks are sorted by
+//	predicted cost, largest first, and dealt out to one queue per thread;
+//	each thread runs its own queue front to back, and once it is empty
+//	steals the smallest tasks from the back of the others.
+void run_work_stealing(
+		const std::vector< long long > &cost,
+		int threads,
+		const std::function< void( int, int ) > &task,
+		std::vector< thread_load > &load );
+
+//	busiest vs. average thread, steals, etc.
+void print_load_balance( const std::vector< thread_load > &load );
+
+#endif
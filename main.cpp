@@ -4,44 +4,91 @@
 #include <cassert>
 #include <vector>
 #include <map>
+#include <cstring>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
 
 #include <ft2build.h>
 #include FT_FREETYPE_H
 #include FT_GLYPH_H
 
 #include "BinPacker.hpp"
+#include "BoundedQueue.hpp"
+#include "DistanceField.hpp"
 #include "EncodingHelper.hpp"
+#include "GlyphSDF.hpp"
 #include "lodepng.h"
+#include "OutlineCache.hpp"
+#include "OutlineSDF.hpp"
+#include "PnmStream.hpp"
 #include "stb_image.h"
+#include "WorkStealing.hpp"
 
 using namespace std;
 
-struct sdf_glyph
+//	settings that can be changed from the command line ("--name=value")
+struct sdf_options
 {
-	int ID;
-	int width, height;
-	int x, y;
-	float xoff, yoff;
-	float xadv;
+	sdf_backend backend;
+	//	compare every sample against get_SDF_radial and report the error
+	bool measure_error;
+	//	time every backend on the same bitmaps
+	bool benchmark;
+	//	glyph render threads, 0 means one per hardware thread
+	int jobs;
+	//	split rasterizing, SDF and compositing into pipeline stages
+	bool pipeline;
+	//	image mode: average the full resolution distance over each texel
+	//	instead of sampling it at one point
+	bool image_box_filter;
+	//	image mode: read PGM / PBM files a strip at a time
+	bool stream;
+	//	rendered pixels per SDF pixel, 0 means the backend's default
+	int oversample;
+	//	fonts: multi-channel SDF from the outline in R, G, B (the usual
+	//	SDF stays in A)
+	bool msdf;
 };
 
+bool parse_option(
+		const char* arg,
+		sdf_options &options );
+
 bool render_signed_distance_font(
 		FT_Library &ft_lib,
 		const char* font_file,
 		const char* map_file,
 		int texture_size,
-		bool export_c_header );
+		bool export_c_header,
+		const sdf_options &options );
 
 bool render_signed_distance_image(
 		const char* image_file,
 		int texture_size,
-		bool export_c_header );
+		bool export_c_header,
+		const sdf_options &options );
 
-unsigned char get_SDF_radial(
-		unsigned char *fontmap,
-		int w, int h,
-		int x, int y,
-		int max_radius );
+//	streams PGM / PBM images a strip at a time (false for other formats,
+//	and it refuses the options that need the whole image)
+bool render_signed_distance_image_streamed(
+		const char* image_file,
+		int texture_size,
+		const sdf_options &options );
+
+//	map the values of an image to 0 / 255, asking for a threshold if
+//	ask_threshold (else everything above the smallest value is 255)
+void build_threshold_LUT(
+		const std::vector< long long > &histogram,
+		bool keep_coverage,
+		bool ask_threshold,
+		unsigned char lut[256] );
+
+int save_png_SDImage(
+		const char* image_file,
+		int texture_size,
+		const std::vector< unsigned char > &pdata );
 
 bool gen_pack_list(
 		FT_Face &ft_face,
@@ -50,6 +97,60 @@ bool gen_pack_list(
 		const std::vector< int > &render_list,
 		std::vector< sdf_glyph > &packed_glyphs );
 
+//	the same from the outline cache (reads nothing else, so any thread
+//	may run it)
+bool gen_pack_list_cached(
+		const outline_cache &cache,
+		int pixel_size,
+		int pack_tex_size,
+		std::vector< sdf_glyph > &packed_glyphs );
+
+//	the largest pixel size that packs, starting from predict_pixel_size
+//	and trying 'jobs' sizes at a time
+int search_pixel_size_cached(
+		const outline_cache &cache,
+		int pack_tex_size,
+		int jobs );
+
+//	Estimate the largest pixel size whose tiles will pack into the
+//	texture: at pixel size sz a glyph's tile is about (w sz + 8) x
+//	(h sz + 8) texels (w, h in ems), and the packer fills about
+//	'efficiency' of the texture.
+int predict_pixel_size(
+		const outline_cache &cache,
+		int pack_tex_size,
+		double efficiency );
+
+//	the total area of the tiles at pixel_size, and the longest side
+double cached_tile_area(
+		const outline_cache &cache,
+		int pixel_size,
+		int &widest );
+
+//	size the glyphs' tiles and pack them, false if they don't all fit
+//	(add_glyph_tile already gives up once the tiles couldn't possibly
+//	fit: one wider than the texture, or more area than it has)
+bool add_glyph_tile(
+		int ID, int glyph_index,
+		int left, int top,
+		int w, int h,
+		float advance,
+		int pack_tex_size,
+		long long &area,
+		std::vector< int > &rectangle_info,
+		std::vector< sdf_glyph > &packed_glyphs );
+bool pack_glyph_tiles(
+		const std::vector< int > &rectangle_info,
+		int pack_tex_size,
+		std::vector< sdf_glyph > &packed_glyphs );
+
+//	load every glyph in render_list into the cache, false if the font
+//	has no scalable outlines
+bool build_outline_cache(
+		FT_Face &ft_face,
+		const std::vector< int > &render_list,
+		outline_cache &cache );
+
 int save_png_SDFont(
 		const char* orig_filename,
 		const char* font_name,
@@ -72,22 +173,118 @@ int map_char_id(
 
 int load_glyph( 
 		FT_Face &ft_face,
-		int char_id );
+		int char_id,
+		FT_Int32 load_flags );
+
+bool rasterize_glyph(
+		FT_Face &ft_face,
+		const sdf_glyph &glyph,
+		const sdf_options &options,
+		glyph_raster &raster );
+
+//	one byte per texel, or RGBA with --msdf
+void compute_glyph_SDF(
+		const glyph_raster &raster,
+		const sdf_glyph &glyph,
+		const sdf_options &options,
+		std::vector< unsigned char > &sdf,
+		sdf_error_stats &error_stats,
+		sdf_benchmark &bench );
+
+void composite_glyph_SDF(
+		const sdf_glyph &glyph,
+		const std::vector< unsigned char > &sdf,
+		int texture_size,
+		std::vector< unsigned char > &pdata );
+
+bool render_glyph_SDF(
+		FT_Face &ft_face,
+		const sdf_glyph &glyph,
+		const sdf_options &options,
+		int texture_size,
+		std::vector< unsigned char > &pdata,
+		sdf_error_stats &error_stats,
+		sdf_benchmark &bench );
+
+void render_glyphs_pipelined(
+		std::vector< FT_Face > &raster_faces,
+		int sdf_jobs,
+		const std::vector< sdf_glyph > &glyphs,
+		const sdf_options &options,
+		int texture_size,
+		std::vector< unsigned char > &pdata,
+		std::vector< sdf_error_stats > &thread_errors,
+		std::vector< sdf_benchmark > &thread_benches );
+
+bool read_file_bytes(
+		const char* file_name,
+		std::vector< unsigned char > &bytes );
 
 //	number of rendered pixels per SDF pixel
-const int scaler = 16;
+int scaler = 16;
 //	(larger value means higher quality, up to a point)
+//	how the glyphs are rasterized (the anti-aliased EDT wants coverage)
+FT_Render_Mode glyph_render_mode = FT_RENDER_MODE_MONO;
 
 int main( int argc, char **argv )
 {
 	printf( "Signed Distance Bitmap Font Tool\n" );
 	printf( "Jonathan \"lonesock\" Dummer\n" );
 	printf( "\n" );
+
+	//	pull out the "--name=value" options, keep the rest in order
+	sdf_options options;
+	options.backend = SDF_BACKEND_EDT;
+	options.measure_error = false;
+	options.benchmark = false;
+	options.jobs = 0;
+	options.pipeline = false;
+	options.image_box_filter = false;
+	options.stream = false;
+	options.oversample = 0;
+	options.msdf = false;
+	int num_args = 1;
+	for( int i = 1; i < argc; ++i )
+	{
+		if( strncmp( argv[i], "--", 2 ) == 0 )
+		{
+			if( !parse_option( argv[i], options ) )
+			{
+				printf( "Unknown option: '%s'\n", argv[i] );
+				return -1;
+			}
+		} else
+		{
+			argv[num_args++] = argv[i];
+		}
+	}
+	argc = num_args;
+	//	each generator knows how its glyphs should be rasterized
+	const sdf_generator &generator = get_sdf_generator( options.backend );
+	glyph_render_mode = generator.render_mode;
+	scaler = generator.default_scaler;
+	if( options.oversample > 0 )
+	{
+		scaler = options.oversample;
+	}
+
 	if( argc < 2 )
 	{
 		printf( "usage: sdfont <fontfile.ttf>\n" );
 		printf( "usage: sdfont <fontfile.ttf> <encoding.txt>\n" );
 		printf( "usage: sdfont <fontfile.ttf> <encoding.txt> <size:64..4096>\n" );
+		printf( "options:\n" );
+		printf( "  --sdf-backend=<%s>\n", sdf_backend_list() );
+		printf( "  --measure-error    (report the error vs. the radial search)\n" );
+		printf( "  --benchmark        (time all backends against the radial search)\n" );
+		printf( "  --radial-isa=<auto|scalar|sse2|avx2>\n" );
+		printf( "  --jobs=<threads>   (default: one per hardware thread)\n" );
+		printf( "  --pipeline         (rasterize / SDF / composite in separate threads)\n" );
+		printf( "  --image-filter=<point|box>  (box: full resolution EDT, then downsample)\n" );
+		printf( "  --stream           (PGM / PBM images: only keep a band of rows in memory,\n" );
+		printf( "                      not with box filtering, --measure-error or --benchmark)\n" );
+		printf( "  --oversample=<1..64>  (glyph pixels per SDF texel, default 16, aaedt 4)\n" );
+		printf( "  --msdf             (fonts: multi-channel SDF in RGB, the SDF in alpha)\n" );
 		system( "pause" );
 		return -1;
 	}
@@ -132,12 +329,21 @@ int main( int argc, char **argv )
 		return -1;
 	}
 
+	//	images have no glyph to work from, they get the exact EDT instead
+	sdf_options image_options = options;
+	if( sdf_backend_needs_glyph( image_options.backend ) )
+	{
+		image_options.backend = SDF_BACKEND_EDT;
+	}
 	//	this may be either an image, or a font file, try the image first
-	if( !render_signed_distance_image( argv[1], texture_size, export_c_header ) )
+	if( options.stream && render_signed_distance_image_streamed( argv[1], texture_size, image_options ) )
+	{
+		//	done (or refused), it was a PGM / PBM image
+	} else if( !render_signed_distance_image( argv[1], texture_size, export_c_header, image_options ) )
 	{
 		//	didn't work, try the font
 		const char * map_file = (argc >= 3) ? argv[2] : NULL;
-		render_signed_distance_font( ft_lib, argv[1], map_file, texture_size, export_c_header );
+		render_signed_distance_font( ft_lib, argv[1], map_file, texture_size, export_c_header, options );
 	}
 
 	ft_err = FT_Done_FreeType( ft_lib );
@@ -146,10 +352,73 @@ int main( int argc, char **argv )
     return 0;
 }
 
+bool parse_option(
+		const char* arg,
+		sdf_options &options )
+{
+	//	simple switches first
+	if( strcmp( arg, "--measure-error" ) == 0 )
+	{
+		options.measure_error = true;
+		return true;
+	}
+	if( strcmp( arg, "--benchmark" ) == 0 )
+	{
+		options.benchmark = true;
+		return true;
+	}
+	if( strcmp( arg, "--pipeline" ) == 0 )
+	{
+		options.pipeline = true;
+		return true;
+	}
+	if( strcmp( arg, "--stream" ) == 0 )
+	{
+		options.stream = true;
+		return true;
+	}
+	if( strcmp( arg, "--msdf" ) == 0 )
+	{
+		options.msdf = true;
+		return true;
+	}
+	//	then the ones that need a value
+	const char *value = strchr( arg, '=' );
+	if( value == NULL )
+	{
+		return false;
+	}
+	++value;
+	if( strncmp( arg, "--sdf-backend=", value - arg ) == 0 )
+	{
+		return parse_sdf_backend( value, options.backend );
+	}
+	if( strncmp( arg, "--radial-isa=", value - arg ) == 0 )
+	{
+		return set_radial_isa( value );
+	}
+	if( strncmp( arg, "--image-filter=", value - arg ) == 0 )
+	{
+		options.image_box_filter = (strcmp( value, "box" ) == 0);
+		return options.image_box_filter || (strcmp( value, "point" ) == 0);
+	}
+	if( strncmp( arg, "--oversample=", value - arg ) == 0 )
+	{
+		return (sscanf( value, "%i", &options.oversample ) == 1) &&
+				(options.oversample >= 1) && (options.oversample <= 64);
+	}
+	if( strncmp( arg, "--jobs=", value - arg ) == 0 )
+	{
+		return (sscanf( value, "%i", &options.jobs ) == 1) && (options.jobs >= 0);
+	}
+	return false;
+}
+
 bool render_signed_distance_image(
 		const char* image_file,
 		int texture_size,
-		bool export_c_header )
+		bool export_c_header,
+		const sdf_options &options )
 {
 	//	try to load this file as an image
 	int w, h, channels;
@@ -196,11 +465,8 @@ bool render_signed_distance_image(
 	stbi_image_free( img );
 	//	is this channel strictly 2 values?
 	bool needs_threshold = false;
-	int vmax, vmin;
 	{
 		int val0 = img_data[0], val = -1;
-		vmin = img_data[0];
-		vmax = img_data[0];
 		for( int i = 0; i < w*h; ++i )
 		{
 			//	do I need a threshold?
@@ -215,18 +481,111 @@ bool render_signed_distance_image(
 					needs_threshold = (val != img_data[i]);
 				}
 			}
-			//	find min and max, just in case
-			if( img_data[i] < vmin )
-			{
-				vmin = img_data[i];
-			}
-			if( img_data[i] > vmax )
+		}
+	}
+	//	map it to strictly 0 / 255
+	std::vector< long long > histogram( 256, 0 );
+	for( int i = 0; i < w*h; ++i )
+	{
+		++histogram[img_data[i]];
+	}
+	unsigned char lut[256];
+	build_threshold_LUT( histogram, options.backend == SDF_BACKEND_AAEDT, needs_threshold, lut );
+	for( int i = 0; i < w*h; ++i )
+	{
+		img_data[i] = lut[img_data[i]];
+	}
+
+	//	OK, I'm finally ready to perform the SDF analysis
+	int sw;
+	if( w > h )
+	{
+		sw = 2 * w / texture_size;
+	} else
+	{
+		sw = 2 * h / texture_size;
+	}
+	std::vector<unsigned char> pdata( 4 * texture_size * texture_size, 0 );
+	std::vector< int > sample_x( texture_size ), sample_y( texture_size );
+	for( int i = 0; i < texture_size; ++i )
+	{
+		sample_x[i] = i * (w-1) / (texture_size-1);
+		sample_y[i] = i * (h-1) / (texture_size-1);
+	}
+	std::vector< unsigned char > sdf( texture_size * texture_size );
+	std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+	if( options.image_box_filter )
+	{
+		render_SDF_image_box(
+				&img_data[0], w, h, texture_size, texture_size,
+				sw, options.jobs, &sdf[0] );
+	} else
+	{
+		render_SDF_grid_tiled(
+				options.backend, &img_data[0], w, h,
+				sample_x, sample_y, sw, options.jobs, &sdf[0] );
+	}
+	std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+	printf( "SDF (%s, radius %i) took %1.3f seconds\n",
+			options.image_box_filter ? "full EDT + box filter" : sdf_backend_name( options.backend ),
+			sw, std::chrono::duration< double >( t1 - t0 ).count() );
+	if( options.measure_error )
+	{
+		sdf_error_stats stats;
+		measure_SDF_error(
+				&img_data[0], w, h,
+				sample_x, sample_y, sw, &sdf[0], stats );
+		print_SDF_error( stats );
+	}
+	if( options.benchmark )
+	{
+		sdf_benchmark bench;
+		benchmark_SDF_grid(
+				&img_data[0], w, h,
+				sample_x, sample_y, sw, bench );
+		print_SDF_benchmark( bench );
+	}
+	for( int i = 0; i < texture_size * texture_size; ++i )
+	{
+		pdata[i*4+0] = sdf[i];
+		pdata[i*4+1] = sdf[i];
+		pdata[i*4+2] = sdf[i];
+		pdata[i*4+3] = sdf[i];
+	}
+
+	save_png_SDImage( image_file, texture_size, pdata );
+
+	return true;
+}
+
+void build_threshold_LUT(
+		const std::vector< long long > &histogram,
+		bool keep_coverage,
+		bool ask_threshold,
+		unsigned char lut[256] )
+{
+	int vmin = -1, vmax = -1;
+	for( int v = 0; v < 256; ++v )
+	{
+		lut[v] = v;
+		if( histogram[v] > 0 )
+		{
+			if( vmin < 0 )
 			{
-				vmax = img_data[i];
+				vmin = v;
 			}
+			vmax = v;
 		}
 	}
-	if( needs_threshold )
+	if( keep_coverage && (vmax > vmin) )
+	{
+		//	the anti-aliased EDT reads the values in between as coverage
+		for( int v = 0; v < 256; ++v )
+		{
+			int c = (v - vmin) * 255 / (vmax - vmin);
+			lut[v] = std::min( std::max( c, 0 ), 255 );
+		}
+	} else if( ask_threshold )
 	{
 		int thresh;
 		printf( "The image needs a threshold, between %i and %i (< threshold is 0): ", vmin, vmax );
@@ -239,47 +598,169 @@ bool render_signed_distance_image(
 			thresh = vmax;
 		}
 		printf( "using threshold=%i\n", thresh );
-		for( int i = 0; i < w*h; ++i )
+		for( int v = 0; v < 256; ++v )
 		{
-			if( img_data[i] < thresh )
-			{
-				img_data[i] = 0;
-			} else
-			{
-				img_data[i] = 255;
-			}
+			lut[v] = (v < thresh) ? 0 : 255;
+		}
+	} else if( vmax > vmin )
+	{
+		//	strictly 2 values, but the distance code wants 0 and 255
+		for( int v = 0; v < 256; ++v )
+		{
+			lut[v] = (v == vmin) ? 0 : 255;
 		}
 	}
+}
 
-	//	OK, I'm finally ready to perform the SDF analysis
-	int sw;
-	if( w > h )
+bool render_signed_distance_image_streamed(
+		const char* image_file,
+		int texture_size,
+		const sdf_options &options )
+{
+	pnm_stream in;
+	if( !in.open( image_file ) )
 	{
-		sw = 2 * w / texture_size;
-	} else
+		return false;
+	}
+	int w = in.w;
+	int h = in.h;
+	printf( "Streaming '%s', %i x %i\n", image_file, w, h );
+	//	these all need the whole image in memory, which is what --stream avoids
+	if( options.image_box_filter || options.measure_error || options.benchmark )
 	{
-		sw = 2 * h / texture_size;
+		printf( "--stream can't be combined with --image-filter=box, --measure-error or --benchmark\n" );
+		return true;
 	}
-	std::vector<unsigned char> pdata( 4 * texture_size * texture_size, 0 );
-	img = &(img_data[0]);
-	for( int j = 0; j < texture_size; ++j )
-	{
-		for( int i = 0; i < texture_size; ++i )
-		{
-			int sx = i * (w-1) / (texture_size-1);
-			int sy = j * (h-1) / (texture_size-1);
-			int pd_idx = (i+j*texture_size) * 4;
-			pdata[pd_idx] =
-				get_SDF_radial
-						( img, w, h,
-						sx, sy, sw );
-			pdata[pd_idx+1] = pdata[pd_idx];
-			pdata[pd_idx+2] = pdata[pd_idx];
-			pdata[pd_idx+3] = pdata[pd_idx];
+	if( (w <= texture_size) && (h <= texture_size) )
+	{
+		printf( "The output texture size is larger than the input image dimensions!\n" );
+		return false;
+	}
+	//	about 4 MB per strip
+	int strip = std::max( 1, std::min( h, (1 << 22) / w ) );
+	std::vector< unsigned char > rows( (size_t)strip * w );
+
+	//	pass 1: which values are there?
+	std::vector< long long > histogram( 256, 0 );
+	for( int y = 0; y < h; y += strip )
+	{
+		int n = std::min( strip, h - y );
+		if( !in.read_rows( n, &rows[0] ) )
+		{
+			printf( "Failed reading '%s'\n", image_file );
+			return false;
+		}
+		for( size_t i = 0; i < (size_t)n * w; ++i )
+		{
+			++histogram[rows[i]];
 		}
 	}
+	int values = 0;
+	for( int v = 0; v < 256; ++v )
+	{
+		values += (histogram[v] > 0);
+	}
+	unsigned char lut[256];
+	build_threshold_LUT( histogram, options.backend == SDF_BACKEND_AAEDT, values > 2, lut );
 
-	//	save the image
+	//	pass 2: every output row only needs the source rows within sw of
+	//	its sample row, so keep a sliding window of those, and do as many
+	//	output rows per window as fit in the row budget
+	int sw = 2 * std::max( w, h ) / texture_size;
+	std::vector< int > sample_x( texture_size ), sample_y( texture_size );
+	for( int i = 0; i < texture_size; ++i )
+	{
+		sample_x[i] = i * (w-1) / (texture_size-1);
+		sample_y[i] = i * (h-1) / (texture_size-1);
+	}
+	int max_rows = std::max( 2 * sw + 1 + 8 * (h / texture_size), strip );
+	//	the live rows start window_start rows into the buffer, and dropping
+	//	rows just moves the start.  A band never holds more than max_rows
+	//	plus a strip, so with room for twice that, the live rows only need
+	//	moving back to the front about once per that many rows read.
+	int window_cap = std::min( 2 * (max_rows + strip), h );
+	std::vector< unsigned char > window;
+	int window_start = 0;
+	int window_y0 = 0;
+	int window_rows = 0;
+	size_t peak_bytes = 0;
+	std::vector< unsigned char > sdf( texture_size * texture_size );
+	in.rewind();
+	std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+	for( int j0 = 0; j0 < texture_size; )
+	{
+		int a = std::max( sample_y[j0] - sw, 0 );
+		int j1 = j0 + 1;
+		while( (j1 < texture_size) && (sample_y[j1] + sw - a < max_rows) )
+		{
+			++j1;
+		}
+		int b = std::min( sample_y[j1-1] + sw, h - 1 );
+		//	drop the rows nobody needs any more
+		if( a > window_y0 )
+		{
+			int drop = std::min( a - window_y0, window_rows );
+			window_start += drop;
+			window_rows -= drop;
+			window_y0 = a;
+		}
+		//	and read up to row b
+		while( window_y0 + window_rows <= b )
+		{
+			int n = std::min( strip, h - (window_y0 + window_rows) );
+			if( window_start + window_rows + n > window_cap )
+			{
+				memmove( &window[0], &window[(size_t)window_start * w], (size_t)window_rows * w );
+				window.resize( (size_t)window_rows * w );
+				window_start = 0;
+			}
+			size_t at = window.size();
+			window.resize( at + (size_t)n * w );
+			if( !in.read_rows( n, &window[at] ) )
+			{
+				printf( "Failed reading '%s'\n", image_file );
+				return false;
+			}
+			for( size_t i = at; i < window.size(); ++i )
+			{
+				window[i] = lut[window[i]];
+			}
+			window_rows += n;
+		}
+		peak_bytes = std::max( peak_bytes, window.size() );
+		std::vector< int > ys( sample_y.begin() + j0, sample_y.begin() + j1 );
+		for( unsigned int j = 0; j < ys.size(); ++j )
+		{
+			ys[j] -= window_y0;
+		}
+		render_SDF_grid_tiled(
+				options.backend, &window[(size_t)window_start * w], w, window_rows,
+				sample_x, ys, sw, options.jobs, &sdf[j0 * texture_size] );
+		j0 = j1;
+	}
+	std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+	printf( "SDF (%s, radius %i) took %1.3f seconds, at most %i of %i rows (%1.1f MB) in memory\n",
+			sdf_backend_name( options.backend ), sw,
+			std::chrono::duration< double >( t1 - t0 ).count(),
+			(int)(peak_bytes / w), h, peak_bytes / 1048576.0 );
+
+	std::vector<unsigned char> pdata( 4 * texture_size * texture_size, 0 );
+	for( int i = 0; i < texture_size * texture_size; ++i )
+	{
+		pdata[i*4+0] = sdf[i];
+		pdata[i*4+1] = sdf[i];
+		pdata[i*4+2] = sdf[i];
+		pdata[i*4+3] = sdf[i];
+	}
+	save_png_SDImage( image_file, texture_size, pdata );
+	return true;
+}
+
+int save_png_SDImage(
+		const char* image_file,
+		int texture_size,
+		const std::vector< unsigned char > &pdata )
+{
 	int fn_size = strlen( image_file ) + 100;
 	char *fn = new char[ fn_size ];
 	#if 0
@@ -295,9 +776,9 @@ bool render_signed_distance_image(
 	int tin = clock();
 	encoder.encode( buffer, pdata.empty() ? 0 : &pdata[0], texture_size, texture_size );
 	LodePNG::saveFile( buffer, fn );
+	delete [] fn;
 	tin = clock() - tin;
-
-	return true;
+	return tin;
 }
 
 bool render_signed_distance_font(
@@ -305,7 +786,8 @@ bool render_signed_distance_font(
 		const char* font_file,
 		const char* map_file,
 		int texture_size,
-		bool export_c_header )
+		bool export_c_header,
+		const sdf_options &options )
 {
 	std::map<int, int> char_map;
 	std::vector<int> render_list;
@@ -369,6 +851,14 @@ bool render_signed_distance_font(
 		}
 	}
 
+	//	every trial size is scaled from the same outlines
+	outline_cache cache;
+	bool cached = build_outline_cache( ft_face, render_list, cache );
+	if( cached )
+	{
+		printf( "Outline cache: %i glyphs, %.1f KB\n",
+				(int)cache.char_ids.size(), cache.bytes / 1024.0 );
+	}
 	//	find the perfect size
 	printf( "\nDetermining ideal font pixel size: " );
 	std::vector< sdf_glyph > all_glyphs;
@@ -376,25 +866,53 @@ bool render_signed_distance_font(
 	//	(intentionally low, the first trial will be at sz*2, so 8x8)
 	int sz = 4;
 	bool keep_going = true;
-	while( keep_going )
-	{
-		sz <<= 1;
-		printf( " %i", sz );
-		keep_going = gen_pack_list( ft_face, sz, texture_size, render_list, all_glyphs );
-	}
-	int sz_step = sz >> 2;
-	while( sz_step )
+	if( !cached )
 	{
-		if( keep_going )
+		while( keep_going )
 		{
-			sz += sz_step;
-		} else
+			sz <<= 1;
+			printf( " %i", sz );
+			keep_going = gen_pack_list( ft_face, sz, texture_size, render_list, all_glyphs );
+		}
+		int sz_step = sz >> 2;
+		while( sz_step )
 		{
-			sz -= sz_step;
+			if( keep_going )
+			{
+				sz += sz_step;
+			} else
+			{
+				sz -= sz_step;
+			}
+			printf( " %i", sz );
+			sz_step >>= 1;
+			keep_going = gen_pack_list( ft_face, sz, texture_size, render_list, all_glyphs );
 		}
-		printf( " %i", sz );
-		sz_step >>= 1;
+	} else
+	{
+		//	the trials share nothing but the cache, so each thread can
+		//	pack a different size
+		int search_jobs = options.jobs;
+		if( search_jobs < 1 )
+		{
+			search_jobs = std::thread::hardware_concurrency();
+		}
+		sz = search_pixel_size_cached( cache, texture_size, std::max( 1, search_jobs ) );
+		//	the cache skips hinting, which can move a glyph's box by a
+		//	pixel (1/scaler of a texel), so settle the last step on the
+		//	glyphs as they will be rendered
+		free_outline_cache( cache );
 		keep_going = gen_pack_list( ft_face, sz, texture_size, render_list, all_glyphs );
+		std::vector< sdf_glyph > larger_glyphs;
+		while( keep_going &&
+			gen_pack_list( ft_face, sz + 1, texture_size, render_list, larger_glyphs ) )
+		{
+			++sz;
+			printf( " %i", sz );
+			all_glyphs.swap( larger_glyphs );
+		}
+		//	(the render needs the face back at the size that fit)
+		FT_Set_Pixel_Sizes( ft_face, sz * scaler, 0 );
 	}
 	//	just in case
 	while( (!keep_going) && (sz > 1) )
@@ -416,74 +934,122 @@ bool render_signed_distance_font(
 	//	(use all four channels, so PNG compression is simple)
 	std::vector<unsigned char> pdata( 4 * texture_size * texture_size, 0 );
 
-	//	render all the glyphs individually
-	printf( "\nRendering characters into a packed %i^2 image:\n", texture_size );
-	int tin = clock();
-	int packed_glyph_index = 0;
-	for( unsigned int char_index = 0; char_index < render_list.size(); ++char_index )
+	//	each extra thread gets its own FT_Library and FT_Face (neither may
+	//	be shared between threads), opened from one in-memory copy of the
+	//	font, while the first thread keeps using ft_face
+	int jobs = options.jobs;
+	if( jobs < 1 )
 	{
-		int char_id = load_glyph( ft_face, render_list[char_index]);
-		if( char_id < 0 )
-		{
-			continue;
-		}
-		
-		int w = ft_face->glyph->bitmap.width;
-		int h = ft_face->glyph->bitmap.rows;
-		int p = ft_face->glyph->bitmap.pitch;
-
-		//	oversize the holding buffer so I can smooth it!
-		int sw = w + scaler * 8; // * 4;
-		int sh = h + scaler * 8; // * 4;
-		unsigned char smooth_buf[sw * sh];
-		for( int i = 0; i < sw * sh; ++i )
+		jobs = std::thread::hardware_concurrency();
+	}
+	jobs = std::max( 1, std::min( jobs, (int)all_glyphs.size() ) );
+	//	in the pipeline only the rasterizers need a face, about 1 in 4
+	//	threads (FreeType is much cheaper than the distance search), and
+	//	the rest compute the SDFs while this thread composites
+	int sdf_jobs = 0;
+	int face_jobs = jobs;
+	if( options.pipeline )
+	{
+		face_jobs = std::max( 1, jobs / 4 );
+		sdf_jobs = std::max( 1, jobs - face_jobs );
+	}
+	std::vector< unsigned char > font_data;
+	if( (face_jobs > 1) && !read_file_bytes( font_file, font_data ) )
+	{
+		face_jobs = 1;
+	}
+	std::vector< FT_Library > thread_libs;
+	std::vector< FT_Face > thread_faces( 1, ft_face );
+	for( int k = 1; k < face_jobs; ++k )
+	{
+		FT_Library lib;
+		FT_Face face;
+		if( FT_Init_FreeType( &lib ) )
 		{
-			smooth_buf[i] = 0;
+			break;
 		}
-
-		//	copy the glyph into the buffer to be smoothed
-		unsigned char * buf = ft_face->glyph->bitmap.buffer;
-		for( int j = 0; j < h; ++j )
+		if( FT_New_Memory_Face( lib, &font_data[0], font_data.size(), 0, &face ) ||
+			FT_Set_Pixel_Sizes( face, sz * scaler, 0 ) )
 		{
-			for( int i = 0; i < w; ++i )
-			{
-				int value = 255 * ((buf[j * p + (i>>3)] >> (7 - (i & 7))) & 1);
-				smooth_buf[i + scaler*2 + (j + scaler*2) * sw] = value;
-			}
+			FT_Done_FreeType( lib );
+			break;
 		}
+		thread_libs.push_back( lib );
+		thread_faces.push_back( face );
+	}
+	face_jobs = thread_faces.size();
 
-		//	do the SDF
-		int sdfw = all_glyphs[packed_glyph_index].width;
-		int sdfx = all_glyphs[packed_glyph_index].x;
-		int sdfh = all_glyphs[packed_glyph_index].height;
-		int sdfy = all_glyphs[packed_glyph_index].y;
-		for( int j = 0; j < sdfh; ++j )
-		{
-			for( int i = 0; i < sdfw; ++i )
-			{
-				int pd_idx = (i+sdfx+(j+sdfy)*texture_size) * 4;
-				pdata[pd_idx] =
-					//get_SDF
-					get_SDF_radial
-							( smooth_buf, sw, sh,
-							i*scaler + (scaler/2), j*scaler + (scaler/2),
-							2*scaler );
-				pdata[pd_idx+1] = pdata[pd_idx];
-				pdata[pd_idx+2] = pdata[pd_idx];
-				pdata[pd_idx+3] = pdata[pd_idx];
-			}
-		}
-		++packed_glyph_index;
+	//	render all the glyphs individually
+	printf( "\nRendering characters into a packed %i^2 image:\n", texture_size );
+	if( options.pipeline )
+	{
+		printf( "SDF backend: %s (radial kernel: %s), pipeline of %i rasterizer%s + %i SDF thread%s\n",
+				sdf_backend_name( options.backend ), radial_isa_name(),
+				face_jobs, (face_jobs > 1) ? "s" : "",
+				sdf_jobs, (sdf_jobs > 1) ? "s" : "" );
+		jobs = sdf_jobs;
+	} else
+	{
+		printf( "SDF backend: %s (radial kernel: %s), %i thread%s\n",
+				sdf_backend_name( options.backend ), radial_isa_name(),
+				face_jobs, (face_jobs > 1) ? "s" : "" );
+		jobs = face_jobs;
 	}
-	tin = clock() - tin;
-	printf( "\nRenderint took %1.3f seconds\n\n", 0.001f * tin );
+	//	wall time, clock() would add up the CPU time of every thread
+	std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+	//	every glyph writes its own rectangle of pdata, so the threads only
+	//	need to agree on who renders which glyph.  The cost of a glyph is
+	//	about its area, so schedule the big ones first.
+	std::vector< sdf_error_stats > thread_errors( jobs );
+	std::vector< sdf_benchmark > thread_benches( jobs );
+	std::vector< long long > glyph_cost( all_glyphs.size() );
+	for( unsigned int g = 0; g < all_glyphs.size(); ++g )
+	{
+		glyph_cost[g] = (long long)all_glyphs[g].width * all_glyphs[g].height;
+	}
+	std::vector< thread_load > load;
+	if( options.pipeline )
+	{
+		render_glyphs_pipelined(
+				thread_faces, sdf_jobs, all_glyphs, options,
+				texture_size, pdata, thread_errors, thread_benches );
+	} else
+	{
+		run_work_stealing( glyph_cost, jobs,
+				[&]( int g, int k )
+				{
+					render_glyph_SDF(
+							thread_faces[k], all_glyphs[g], options,
+							texture_size, pdata,
+							thread_errors[k], thread_benches[k] );
+				},
+				load );
+	}
+	sdf_error_stats error_stats;
+	sdf_benchmark bench;
+	for( int k = 0; k < jobs; ++k )
+	{
+		merge_SDF_error( error_stats, thread_errors[k] );
+		merge_SDF_benchmark( bench, thread_benches[k] );
+	}
+	for( int k = 1; k < face_jobs; ++k )
+	{
+		FT_Done_Face( thread_faces[k] );
+		FT_Done_FreeType( thread_libs[k-1] );
+	}
+	std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+	printf( "\nRenderint took %1.3f seconds\n\n",
+			std::chrono::duration< double >( t1 - t0 ).count() );
+	print_load_balance( load );
+	print_SDF_error( error_stats );
+	print_SDF_benchmark( bench );
 
 	printf( "\nCompressing the image to PNG\n" );
-	tin = save_png_SDFont(
+	int tin = save_png_SDFont(
 			font_file, ft_face->family_name,
 			texture_size, texture_size,
 			pdata, all_glyphs, char_map, sz );
-	printf( "Done in %1.3f seconds\n\n", 0.001f * tin );
+	printf( "Done in %1.3f seconds\n\n", (float)tin / CLOCKS_PER_SEC );
 
 	if( export_c_header )
 	{
@@ -492,7 +1058,7 @@ bool render_signed_distance_font(
 				font_file, ft_face->family_name,
 				texture_size, texture_size,
 				pdata, all_glyphs );
-		printf( "Done in %1.3f seconds\n\n", 0.001f * tin );
+		printf( "Done in %1.3f seconds\n\n", (float)tin / CLOCKS_PER_SEC );
 	}
 
 	//	clean up my data
@@ -659,8 +1225,8 @@ int save_c_header_SDFont(
 				fprintf( fp, "\n  " );
 				nchars = 2;
 			}
-			//	print the value
-			int v = img_data[i];
+			//	print the value (alpha, R G B may hold an MSDF)
+			int v = img_data[i+3];
 			fprintf( fp, "%i,", v );
 			//	account for the comma
 			++nchars;
@@ -688,6 +1254,276 @@ int save_c_header_SDFont(
 	return tin;
 }
 
+bool rasterize_glyph(
+		FT_Face &ft_face,
+		const sdf_glyph &glyph,
+		const sdf_options &options,
+		glyph_raster &raster )
+{
+	raster = glyph_raster();
+	const sdf_generator &generator = get_sdf_generator( options.backend );
+	if( !generator.prepare( generator, ft_face, glyph, scaler,
+			options.measure_error || options.benchmark, raster ) )
+	{
+		return false;
+	}
+	if( options.msdf && raster.outline.segments.empty() )
+	{
+		//	--msdf needs the (hinted) outline whatever the backend
+		if( (FT_Load_Glyph( ft_face, glyph.glyph_index, 0 ) != 0) ||
+			(ft_face->glyph->format != FT_GLYPH_FORMAT_OUTLINE) ||
+			!decompose_outline( ft_face->glyph->outline, raster.outline ) )
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+void compute_glyph_SDF(
+		const glyph_raster &raster,
+		const sdf_glyph &glyph,
+		const sdf_options &options,
+		std::vector< unsigned char > &sdf,
+		sdf_error_stats &error_stats,
+		sdf_benchmark &bench )
+{
+	//	do the SDF
+	const sdf_generator &generator = get_sdf_generator( options.backend );
+	std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+	generator.generate( generator, raster, glyph, scaler, sdf );
+	double sdf_seconds = std::chrono::duration< double >(
+			std::chrono::steady_clock::now() - t0 ).count();
+	int sdfw = glyph.width;
+	int sdfh = glyph.height;
+	if( options.measure_error || options.benchmark )
+	{
+		//	the error / benchmark references only know binary bitmaps
+		std::vector< unsigned char > ref_buf;
+		int sw, sh;
+		expand_glyph_raster( raster, scaler, ref_buf, sw, sh );
+		if( raster.gray )
+		{
+			for( unsigned int i = 0; i < ref_buf.size(); ++i )
+			{
+				ref_buf[i] = (ref_buf[i] >= 128) ? 255 : 0;
+			}
+		}
+		std::vector< int > sample_x, sample_y;
+		glyph_sample_points( glyph, scaler, sample_x, sample_y );
+		if( options.measure_error )
+		{
+			measure_SDF_error(
+					&ref_buf[0], sw, sh,
+					sample_x, sample_y, 2*scaler, &sdf[0], error_stats );
+		}
+		if( options.benchmark )
+		{
+			benchmark_SDF_grid(
+					&ref_buf[0], sw, sh,
+					sample_x, sample_y, 2*scaler, bench );
+			if( sdf_backend_needs_glyph( options.backend ) )
+			{
+				//	benchmark_SDF_grid can't run these from a bitmap
+				bench.seconds[options.backend] += raster.seconds + sdf_seconds;
+				std::vector< unsigned char > ref( sdf.size() );
+				render_SDF_grid( SDF_BACKEND_RADIAL, &ref_buf[0], sw, sh,
+						sample_x, sample_y, 2*scaler, &ref[0] );
+				for( unsigned int i = 0; i < sdf.size(); ++i )
+				{
+					bench.mismatches[options.backend] += (sdf[i] != ref[i]);
+				}
+			}
+		}
+	}
+	if( options.msdf )
+	{
+		//	interleave the MSDF with the plain SDF, RGBA
+		std::vector< double > outline_x, outline_y;
+		glyph_texel_centres( glyph, scaler, outline_x, outline_y );
+		std::vector< unsigned char > rgb( sdfw * sdfh * 3 );
+		render_MSDF_outline( raster.outline, outline_x, outline_y, 2*scaler, &rgb[0] );
+		std::vector< unsigned char > rgba( sdfw * sdfh * 4 );
+		for( int i = 0; i < sdfw * sdfh; ++i )
+		{
+			rgba[i*4+0] = rgb[i*3+0];
+			rgba[i*4+1] = rgb[i*3+1];
+			rgba[i*4+2] = rgb[i*3+2];
+			rgba[i*4+3] = sdf[i];
+		}
+		sdf.swap( rgba );
+	}
+}
+
+void composite_glyph_SDF(
+		const sdf_glyph &glyph,
+		const std::vector< unsigned char > &sdf,
+		int texture_size,
+		std::vector< unsigned char > &pdata )
+{
+	int sdfw = glyph.width;
+	int sdfx = glyph.x;
+	int sdfh = glyph.height;
+	int sdfy = glyph.y;
+	if( (int)sdf.size() == sdfw * sdfh * 4 )
+	{
+		//	already RGBA (--msdf)
+		for( int j = 0; j < sdfh; ++j )
+		{
+			memcpy( &pdata[(sdfx+(j+sdfy)*texture_size) * 4],
+					&sdf[j*sdfw*4], sdfw * 4 );
+		}
+		return;
+	}
+	for( int j = 0; j < sdfh; ++j )
+	{
+		for( int i = 0; i < sdfw; ++i )
+		{
+			int pd_idx = (i+sdfx+(j+sdfy)*texture_size) * 4;
+			pdata[pd_idx] = sdf[i + j*sdfw];
+			pdata[pd_idx+1] = pdata[pd_idx];
+			pdata[pd_idx+2] = pdata[pd_idx];
+			pdata[pd_idx+3] = pdata[pd_idx];
+		}
+	}
+}
+
+bool render_glyph_SDF(
+		FT_Face &ft_face,
+		const sdf_glyph &glyph,
+		const sdf_options &options,
+		int texture_size,
+		std::vector< unsigned char > &pdata,
+		sdf_error_stats &error_stats,
+		sdf_benchmark &bench )
+{
+	glyph_raster raster;
+	if( !rasterize_glyph( ft_face, glyph, options, raster ) )
+	{
+		return false;
+	}
+	std::vector< unsigned char > sdf;
+	compute_glyph_SDF( raster, glyph, options, sdf, error_stats, bench );
+	composite_glyph_SDF( glyph, sdf, texture_size, pdata );
+	return true;
+}
+
+//	messages passed down the pipeline, one per glyph
+struct raster_job
+{
+	int glyph;
+	bool ok;
+	glyph_raster raster;
+};
+
+struct sdf_tile
+{
+	int glyph;
+	bool ok;
+	std::vector< unsigned char > sdf;
+};
+
+void render_glyphs_pipelined(
+		std::vector< FT_Face > &raster_faces,
+		int sdf_jobs,
+		const std::vector< sdf_glyph > &glyphs,
+		const sdf_options &options,
+		int texture_size,
+		std::vector< unsigned char > &pdata,
+		std::vector< sdf_error_stats > &thread_errors,
+		std::vector< sdf_benchmark > &thread_benches )
+{
+	int n = glyphs.size();
+	int raster_jobs = raster_faces.size();
+	//	biggest glyphs first, so no thread is left with a big one at the end
+	std::vector< int > order( n );
+	for( int g = 0; g < n; ++g )
+	{
+		order[g] = g;
+	}
+	std::stable_sort( order.begin(), order.end(),
+			[&]( int a, int b )
+			{
+				return glyphs[a].width * glyphs[a].height >
+					glyphs[b].width * glyphs[b].height;
+			} );
+	//	the queues are the only slack between the stages (producers wait
+	//	while they are full), so they cap the glyphs in flight
+	int depth = 2 * sdf_jobs;
+	bounded_queue< raster_job* > rasters( depth );
+	bounded_queue< sdf_tile* > tiles( depth );
+	std::atomic< int > next_glyph( 0 );
+	std::atomic< int > rasterizers_left( raster_jobs );
+	std::atomic< int > in_flight( 0 ), peak_in_flight( 0 );
+
+	auto rasterizer = [&]( int k )
+	{
+		for( int g = next_glyph++; g < n; g = next_glyph++ )
+		{
+			int now = ++in_flight;
+			int peak = peak_in_flight.load();
+			while( (now > peak) && !peak_in_flight.compare_exchange_weak( peak, now ) ) {}
+			raster_job *job = new raster_job;
+			job->glyph = order[g];
+			job->ok = rasterize_glyph( raster_faces[k], glyphs[job->glyph], options, job->raster );
+			rasters.push( job );
+		}
+		//	the last rasterizer out lets the SDF workers finish
+		if( --rasterizers_left == 0 )
+		{
+			rasters.close();
+		}
+	};
+	auto sdf_worker = [&]( int k )
+	{
+		raster_job *job;
+		while( rasters.pop( job ) )
+		{
+			sdf_tile *tile = new sdf_tile;
+			tile->glyph = job->glyph;
+			tile->ok = job->ok;
+			if( job->ok )
+			{
+				compute_glyph_SDF( job->raster, glyphs[job->glyph], options,
+						tile->sdf, thread_errors[k], thread_benches[k] );
+			}
+			delete job;
+			tiles.push( tile );
+		}
+	};
+
+	std::vector< std::thread > threads;
+	for( int k = 0; k < raster_jobs; ++k )
+	{
+		threads.push_back( std::thread( rasterizer, k ) );
+	}
+	for( int k = 0; k < sdf_jobs; ++k )
+	{
+		threads.push_back( std::thread( sdf_worker, k ) );
+	}
+	//	and this thread composites
+	for( int received = 0; received < n; )
+	{
+		sdf_tile *tile;
+		if( !tiles.pop( tile ) )
+		{
+			break;
+		}
+		if( tile->ok )
+		{
+			composite_glyph_SDF( glyphs[tile->glyph], tile->sdf, texture_size, pdata );
+		}
+		delete tile;
+		--in_flight;
+		++received;
+	}
+	for( unsigned int k = 0; k < threads.size(); ++k )
+	{
+		threads[k].join();
+	}
+	printf( "Pipeline: at most %i of %i glyphs in flight\n", peak_in_flight.load(), n );
+}
+
 int map_char_id(
 		int char_id, 
 		FT_Encoding encoding )
@@ -702,15 +1538,15 @@ int map_char_id(
 
 int load_glyph( 
 		FT_Face &ft_face,
-		int char_id )
+		int char_id,
+		FT_Int32 load_flags )
 {
 	for( int i = 0; i < ft_face->num_charmaps; ++i )
 	{
 		int mapped_char_id = map_char_id( char_id, ft_face->charmap->encoding );
 		int glyph_index = FT_Get_Char_Index( ft_face, mapped_char_id );
 		if( glyph_index == 0 ||
-			FT_Load_Glyph( ft_face, glyph_index, 0 ) || 
-			FT_Render_Glyph( ft_face->glyph, FT_RENDER_MODE_MONO ) )
+			FT_Load_Glyph( ft_face, glyph_index, load_flags ) )
 		{
 			int charmap_index = FT_Get_Charmap_Index( ft_face->charmap );
 			charmap_index = ( charmap_index + 1 ) % ft_face->num_charmaps;
@@ -727,6 +1563,23 @@ int load_glyph(
 	return -1;
 }
 
+bool read_file_bytes(
+		const char* file_name,
+		std::vector< unsigned char > &bytes )
+{
+	FILE *f = fopen( file_name, "rb" );
+	if( f == NULL )
+	{
+		return false;
+	}
+	fseek( f, 0, SEEK_END );
+	long size = ftell( f );
+	fseek( f, 0, SEEK_SET );
+	bytes.resize( (size > 0) ? size : 0 );
+	bool ok = (size > 0) && (fread( &bytes[0], 1, size, f ) == (size_t)size);
+	fclose( f );
+	return ok;
+}
 
 bool gen_pack_list(
 		FT_Face &ft_face,
@@ -740,192 +1593,288 @@ bool gen_pack_list(
 	ft_err = FT_Set_Pixel_Sizes( ft_face, pixel_size * scaler, 0 );
 
 	std::vector< int > rectangle_info;
-	std::vector< std::vector<int> > packed_glyph_info;
+	long long area = 0;
 	for( unsigned int char_index = 0; char_index < render_list.size(); ++char_index )
 	{
-		int char_id = load_glyph(ft_face, render_list[char_index]);
-		if( char_id < 0 )
+		int char_id = load_glyph(ft_face, render_list[char_index], 0);
+		//	only the bitmap's size is needed, rendering waits until
+		//	the final size is known
+		int left, top, w, h;
+		if( (char_id < 0) ||
+			!get_glyph_bitmap_box( ft_face->glyph, glyph_render_mode, left, top, w, h ) )
 		{
 			continue;
 		}
-
-		sdf_glyph add_me;
-		//	we have the glyph, already rendered, get the data about it
-		int w = ft_face->glyph->bitmap.width;
-		int h = ft_face->glyph->bitmap.rows;
-		//	oversize the holding buffer so I can smooth it!
-		int sw = w + scaler * 8; // * 4;
-		int sh = h + scaler * 8; // * 4
-		//	do the SDF
-		int sdfw = sw / scaler;
-		int sdfh = sh / scaler;
-		rectangle_info.push_back( sdfw );
-		rectangle_info.push_back( sdfh );
-		//	add in the data I already know
-		add_me.ID = render_list[char_index];
-		add_me.width = sdfw;
-		add_me.height = sdfh;
-		//	these need to be filled in later (after packing)
-		add_me.x = -1;
-		add_me.y = -1;
-		//	these need scaling...
-		add_me.xoff = ft_face->glyph->bitmap_left;
-		add_me.yoff = ft_face->glyph->bitmap_top;
-		add_me.xadv = ft_face->glyph->advance.x / 64.0;
-		//	so scale them (the 1.5's have to do with the padding
-		//	border and the sampling locations for the SDF)
-		add_me.xoff = add_me.xoff / scaler - 3; // - 1.5;
-		add_me.yoff = add_me.yoff / scaler + 3; // + 1.5;
-		add_me.xadv = add_me.xadv / scaler;
-		//	add it to my list
-		packed_glyphs.push_back( add_me );
+		if( !add_glyph_tile( render_list[char_index], FT_Get_Char_Index( ft_face, char_id ),
+				left, top, w, h, ft_face->glyph->advance.x / 64.0,
+				pack_tex_size, area, rectangle_info, packed_glyphs ) )
+		{
+			return false;
+		}
 	}
-	
-	const bool dont_allow_rotation = false;
-	BinPacker bp;
-	bp.Pack( rectangle_info, packed_glyph_info, pack_tex_size, dont_allow_rotation );
-	//	populate the actual coordinates
-	if( packed_glyph_info.size() == 1 )
+	return pack_glyph_tiles( rectangle_info, pack_tex_size, packed_glyphs );
+}
+
+bool gen_pack_list_cached(
+		const outline_cache &cache,
+		int pixel_size,
+		int pack_tex_size,
+		std::vector< sdf_glyph > &packed_glyphs )
+{
+	packed_glyphs.clear();
+	FT_Fixed scale = outline_cache_scale( cache, pixel_size * scaler );
+	std::vector< int > rectangle_info;
+	long long area = 0;
+	for( unsigned int i = 0; i < cache.char_ids.size(); ++i )
 	{
-		//	it all fit into one!
-		unsigned int lim = packed_glyph_info[0].size();
-		for( unsigned int i = 0; i < lim; i += 4 )
+		int glyph_index = cache.glyph_indices[i];
+		int left, top, w, h;
+		get_cached_bitmap_box( cache, glyph_index, pixel_size * scaler,
+				glyph_render_mode, left, top, w, h );
+		//	(FT_Glyph advances are 16.16)
+		FT_Pos advance = FT_MulFix( cache.glyphs[glyph_index]->advance.x >> 10, scale );
+		if( !add_glyph_tile( cache.char_ids[i], glyph_index,
+				left, top, w, h, advance / 64.0,
+				pack_tex_size, area, rectangle_info, packed_glyphs ) )
 		{
-			//	index, x, y, rotated
-			unsigned int idx = packed_glyph_info[0][i+0];
-			packed_glyphs[idx].x = packed_glyph_info[0][i+1];
-			packed_glyphs[idx].y = packed_glyph_info[0][i+2];
+			return false;
 		}
-		return true;
 	}
-	return false;
+	return pack_glyph_tiles( rectangle_info, pack_tex_size, packed_glyphs );
 }
 
-unsigned char get_SDF_radial(
-		unsigned char *fontmap,
-		int w, int h,
-		int x, int y,
-		int max_radius )
+int search_pixel_size_cached(
+		const outline_cache &cache,
+		int pack_tex_size,
+		int jobs )
 {
-	//	hideous brute force method
-	float d2 = max_radius*max_radius+1.0;
-	unsigned char v = fontmap[x+y*w];
-	for( int radius = 1; (radius <= max_radius) && (radius*radius < d2); ++radius )
-	{
-		int line, lo, hi;
-		//	north
-		line = y - radius;
-		if( (line >= 0) && (line < h) )
-		{
-			lo = x - radius;
-			hi = x + radius;
-			if( lo < 0 ) { lo = 0; }
-			if( hi >= w ) { hi = w-1; }
-			int idx = line * w + lo;
-			for( int i = lo; i <= hi; ++i )
+	//	The packer fills 65% to 85% of the texture, so start in the
+	//	middle, step away until the answer is bracketed, then narrow it
+	//	down.  Each round packs 'jobs' sizes at once (so this is a k-ary
+	//	search, binary with one thread), lo always fits (or is 0) and hi
+	//	never does (or is 0 while unknown).
+	int sz = predict_pixel_size( cache, pack_tex_size, 0.75 );
+	int lo = 0, hi = 0;
+	int step = std::max( 1, sz / 32 );
+	//	the first round covers +/- 10% of the prediction
+	std::vector< int > trials( 1, sz );
+	if( jobs > 1 )
+	{
+		trials.clear();
+		for( int k = 0; k < jobs; ++k )
+		{
+			int t = std::max( 1, (int)(sz * (0.9 + 0.2 * k / (jobs - 1))) );
+			if( trials.empty() || (t > trials.back()) )
 			{
-				//	check this pixel
-				if( fontmap[idx] != v )
-				{
-					float nx = i - x;
-					float ny = line - y;
-					float nd2 = nx*nx+ny*ny;
-					if( nd2 < d2 )
-					{
-						d2 = nd2;
-					}
-				}
-				//	move on
-				++idx;
+				trials.push_back( t );
 			}
 		}
-		//	south
-		line = y + radius;
-		if( (line >= 0) && (line < h) )
+	}
+	std::vector< char > fits;
+	std::vector< long long > cost;
+	std::vector< thread_load > load;
+	while( !trials.empty() )
+	{
+		//	every trial has its own glyph list (and BinPacker)
+		fits.assign( trials.size(), 0 );
+		cost.assign( trials.size(), 1 );
+		for( unsigned int i = 0; i < trials.size(); ++i )
 		{
-			lo = x - radius;
-			hi = x + radius;
-			if( lo < 0 ) { lo = 0; }
-			if( hi >= w ) { hi = w-1; }
-			int idx = line * w + lo;
-			for( int i = lo; i <= hi; ++i )
-			{
-				//	check this pixel
-				if( fontmap[idx] != v )
+			printf( " %i", trials[i] );
+		}
+		run_work_stealing( cost, std::min( jobs, (int)trials.size() ),
+				[&]( int i, int )
 				{
-					float nx = i - x;
-					float ny = line - y;
-					float nd2 = nx*nx+ny*ny;
-					if( nd2 < d2 )
-					{
-						d2 = nd2;
-					}
-				}
-				//	move on
-				++idx;
+					std::vector< sdf_glyph > glyphs;
+					fits[i] = gen_pack_list_cached( cache, trials[i], pack_tex_size, glyphs );
+				},
+				load );
+		//	trials are in increasing order, the first failure caps the
+		//	bracket and the last fit below it raises it
+		for( unsigned int i = 0; i < trials.size(); ++i )
+		{
+			if( !fits[i] )
+			{
+				hi = trials[i];
+				break;
 			}
+			lo = trials[i];
 		}
-		//	west
-		line = x - radius;
-		if( (line >= 0) && (line < w) )
+		//	the next round
+		std::vector< int > next;
+		if( hi == 0 )
+		{
+			//	all fit, keep going up
+			for( int k = 1; k <= jobs; ++k )
+			{
+				next.push_back( lo + step * k );
+			}
+			step *= jobs + 1;
+		} else if( (lo == 0) && (trials[0] == hi) && (hi > 1) )
 		{
-			lo = y - radius + 1;
-			hi = y + radius - 1;
-			if( lo < 0 ) { lo = 0; }
-			if( hi >= h ) { hi = h-1; }
-			int idx = lo * w + line;
-			for( int i = lo; i <= hi; ++i )
+			//	none fit, keep going down
+			for( int k = jobs; k >= 1; --k )
 			{
-				//	check this pixel
-				if( fontmap[idx] != v )
+				int t = std::max( 1, hi - step * k );
+				if( next.empty() || (t > next.back()) )
 				{
-					float nx = line - x;
-					float ny = i - y;
-					float nd2 = nx*nx+ny*ny;
-					if( nd2 < d2 )
-					{
-						d2 = nd2;
-					}
+					next.push_back( t );
 				}
-				//	move on
-				idx += w;
 			}
-		}
-		//	east
-		line = x + radius;
-		if( (line >= 0) && (line < w) )
+			step *= jobs + 1;
+		} else
 		{
-			lo = y - radius + 1;
-			hi = y + radius - 1;
-			if( lo < 0 ) { lo = 0; }
-			if( hi >= h ) { hi = h-1; }
-			int idx = lo * w + line;
-			for( int i = lo; i <= hi; ++i )
+			//	split the bracket into jobs + 1 parts
+			for( int k = 1; k <= jobs; ++k )
 			{
-				//	check this pixel
-				if( fontmap[idx] != v )
+				int t = lo + (int)((long long)(hi - lo) * k / (jobs + 1));
+				if( (t > lo) && (t < hi) && (next.empty() || (t > next.back())) )
 				{
-					float nx = line - x;
-					float ny = i - y;
-					float nd2 = nx*nx+ny*ny;
-					if( nd2 < d2 )
-					{
-						d2 = nd2;
-					}
+					next.push_back( t );
 				}
-				//	move on
-				idx += w;
 			}
 		}
+		trials.swap( next );
 	}
-	d2 = sqrtf( d2 );
-	if( v==0 )
+	return std::max( 1, lo );
+}
+
+double cached_tile_area(
+		const outline_cache &cache,
+		int pixel_size,
+		int &widest )
+{
+	double area = 0.0;
+	widest = 0;
+	for( unsigned int i = 0; i < cache.glyph_indices.size(); ++i )
 	{
-		d2 = -d2;
+		int left, top, w, h;
+		get_cached_bitmap_box( cache, cache.glyph_indices[i], pixel_size * scaler,
+				glyph_render_mode, left, top, w, h );
+		//	the same tile size as add_glyph_tile
+		int sdfw = (w + scaler * 8) / scaler;
+		int sdfh = (h + scaler * 8) / scaler;
+		area += (double)sdfw * sdfh;
+		widest = std::max( widest, std::max( sdfw, sdfh ) );
 	}
-	d2 *= 127.5 / max_radius;
-	d2 += 127.5;
-	if( d2 < 0.0 ) d2 = 0.0;
-	if( d2 > 255.0 ) d2 = 255.0;
-	return (unsigned char)(d2 + 0.5);
+	return area;
+}
+
+int predict_pixel_size(
+		const outline_cache &cache,
+		int pack_tex_size,
+		double efficiency )
+{
+	//	the tile area only grows with the size, so bisect on it (no
+	//	packing needed)
+	double room = efficiency * pack_tex_size * pack_tex_size;
+	int lo = 0, hi = pack_tex_size + 1;
+	while( hi - lo > 1 )
+	{
+		int mid = (lo + hi) / 2;
+		int widest;
+		if( (cached_tile_area( cache, mid, widest ) <= room) &&
+			(widest <= pack_tex_size) )
+		{
+			lo = mid;
+		} else
+		{
+			hi = mid;
+		}
+	}
+	return std::max( 1, lo );
+}
+
+bool add_glyph_tile(
+		int ID, int glyph_index,
+		int left, int top,
+		int w, int h,
+		float advance,
+		int pack_tex_size,
+		long long &area,
+		std::vector< int > &rectangle_info,
+		std::vector< sdf_glyph > &packed_glyphs )
+{
+	sdf_glyph add_me;
+	//	oversize the holding buffer so I can smooth it!
+	int sw = w + scaler * 8; // * 4;
+	int sh = h + scaler * 8; // * 4
+	//	do the SDF
+	int sdfw = sw / scaler;
+	int sdfh = sh / scaler;
+	rectangle_info.push_back( sdfw );
+	rectangle_info.push_back( sdfh );
+	//	add in the data I already know
+	add_me.ID = ID;
+	add_me.glyph_index = glyph_index;
+	add_me.width = sdfw;
+	add_me.height = sdfh;
+	//	these need to be filled in later (after packing)
+	add_me.x = -1;
+	add_me.y = -1;
+	//	these need scaling...
+	add_me.xoff = left;
+	add_me.yoff = top;
+	add_me.xadv = advance;
+	add_me.bitmap_left = left;
+	add_me.bitmap_top = top;
+	//	so scale them (the 1.5's have to do with the padding
+	//	border and the sampling locations for the SDF)
+	add_me.xoff = add_me.xoff / scaler - 3; // - 1.5;
+	add_me.yoff = add_me.yoff / scaler + 3; // + 1.5;
+	add_me.xadv = add_me.xadv / scaler;
+	//	add it to my list
+	packed_glyphs.push_back( add_me );
+	//	no need to run the packer if this can't work
+	area += (long long)sdfw * sdfh;
+	return (sdfw <= pack_tex_size) && (sdfh <= pack_tex_size) &&
+		(area <= (long long)pack_tex_size * pack_tex_size);
+}
+
+bool pack_glyph_tiles(
+		const std::vector< int > &rectangle_info,
+		int pack_tex_size,
+		std::vector< sdf_glyph > &packed_glyphs )
+{
+	std::vector< std::vector<int> > packed_glyph_info;
+	const bool dont_allow_rotation = false;
+	BinPacker bp;
+	bp.Pack( rectangle_info, packed_glyph_info, pack_tex_size, dont_allow_rotation );
+	//	populate the actual coordinates
+	if( packed_glyph_info.size() == 1 )
+	{
+		//	it all fit into one!
+		unsigned int lim = packed_glyph_info[0].size();
+		for( unsigned int i = 0; i < lim; i += 4 )
+		{
+			//	index, x, y, rotated
+			unsigned int idx = packed_glyph_info[0][i+0];
+			packed_glyphs[idx].x = packed_glyph_info[0][i+1];
+			packed_glyphs[idx].y = packed_glyph_info[0][i+2];
+		}
+		return true;
+	}
+	return false;
+}
+
+bool build_outline_cache(
+		FT_Face &ft_face,
+		const std::vector< int > &render_list,
+		outline_cache &cache )
+{
+	if( !init_outline_cache( ft_face, cache ) )
+	{
+		return false;
+	}
+	for( unsigned int char_index = 0; char_index < render_list.size(); ++char_index )
+	{
+		//	font units, no hinting
+		int char_id = load_glyph( ft_face, render_list[char_index], FT_LOAD_NO_SCALE );
+		if( char_id >= 0 )
+		{
+			add_cached_glyph( cache, render_list[char_index],
+					FT_Get_Char_Index( ft_face, char_id ), ft_face->glyph );
+		}
+	}
+	return true;
 }